@@ -0,0 +1,137 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+
+#include "shadertoy/AssetDownloader.hpp"
+#include "shadertoy/DiskCache.hpp"
+#include <cstdlib>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <httplib.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+std::string getShaderToyHost() {
+    if(const auto host = std::getenv("SHADERTOY_HOST"); host && *host)  // NOLINT(concurrency-mt-unsafe)
+        return host;
+    return "https://www.shadertoy.com";
+}
+
+static uint64_t getCacheKey(const std::string& path) {
+    return hashString(path, hashString("media"));
+}
+
+AssetDownloader::AssetDownloader(std::string host, Headers headers, const size_t maxConnections, const DiskCache* cache,
+                                 const bool offline)
+    : mHost{ std::move(host) }, mHeaders{ std::move(headers) }, mMaxConnections{ maxConnections }, mCache{ cache },
+      mOffline{ offline } {}
+
+AssetDownloader::~AssetDownloader() {
+    {
+        std::lock_guard lock{ mMutex };
+        mQueue.clear();
+        mClosing = true;
+    }
+    mCondition.notify_all();
+    for(auto& worker : mWorkers)
+        worker.join();
+}
+
+void AssetDownloader::cancel() {
+    {
+        std::lock_guard lock{ mMutex };
+        mQueue.clear();
+        mCancelled = true;
+    }
+    mCondition.notify_all();
+}
+
+void AssetDownloader::enqueue(std::string path, Handler handler, Probe probe) {
+    std::lock_guard lock{ mMutex };
+    mQueue.push_back(Request{ std::move(path), std::move(handler), std::move(probe) });
+    // each worker owns one connection, which is only opened once there is something to fetch
+    if(mWorkers.size() < mMaxConnections)
+        mWorkers.emplace_back([this] { run(); });
+    mCondition.notify_all();
+}
+
+std::vector<std::string> AssetDownloader::wait() {
+    std::vector<std::string> errors;
+    std::unique_lock lock{ mMutex };
+    mCondition.wait(lock, [&] { return mQueue.empty() && mActive == 0; });
+    errors.swap(mErrors);
+    return errors;
+}
+
+void AssetDownloader::run() {
+    std::optional<httplib::Client> client;  // connects on the first cache miss
+    const httplib::Headers headers{ mHeaders.cbegin(), mHeaders.cend() };
+    while(true) {
+        Request request;
+        {
+            std::unique_lock lock{ mMutex };
+            mCondition.wait(lock, [&] { return mClosing || !mQueue.empty(); });
+            if(mQueue.empty())
+                return;
+            request = std::move(mQueue.front());
+            mQueue.pop_front();
+            ++mActive;
+        }
+        std::optional<std::string> error;
+        if(!request.probe || !request.probe()) {
+            std::optional<std::string> body;
+            bool downloaded = false;
+            if(mCache) {
+                if(auto data = mCache->load(getCacheKey(request.path)))
+                    body.emplace(data->cbegin(), data->cend());
+            }
+            if(!body && mOffline) {
+                error = request.path + " is not cached, cannot download it in offline mode";
+            } else if(!body) {
+                if(!client) {
+                    client.emplace(mHost);
+                    client->set_keep_alive(true);
+                }
+                const auto progress = [this](uint64_t, uint64_t) { return !mCancelled; };
+                if(auto res = client->Get(request.path, headers, progress); !res)
+                    error = "Failed to download " + request.path + ": " + httplib::to_string(res.error());
+                else if(res->status != 200)
+                    error = "Failed to download " + request.path + " (Status code = " + std::to_string(res->status) + ")";
+                else {
+                    body = std::move(res->body);
+                    downloaded = true;
+                }
+            }
+            if(body)
+                error = request.handler(*body);
+            // only accepted bodies are cached, best effort: a body that cannot be stored is downloaded again next time
+            if(!error && downloaded && mCache)
+                (void)mCache->store(getCacheKey(request.path), reinterpret_cast<const uint8_t*>(body->data()), body->size());
+        }
+
+        std::lock_guard lock{ mMutex };
+        if(error)
+            mErrors.push_back(std::move(*error));
+        --mActive;
+        mCondition.notify_all();
+    }
+}
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,94 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Config.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+// "https://www.shadertoy.com" unless overridden by the SHADERTOY_HOST environment variable, e.g. "http://127.0.0.1:8000" for
+// a local server that replays recorded API responses and media
+std::string getShaderToyHost();
+
+class DiskCache;
+
+// Fetches paths from one host over a bounded pool of keep-alive connections. Each response body is passed to the handler of
+// its request on the worker thread that received it, so decoding overlaps with the remaining downloads.
+// Code running on worker threads never logs: the downloader, its handlers and probes return errors to the owner of the
+// downloader, which logs them. The downloader itself may therefore be driven from a background thread as well.
+// With a cache, bodies are looked up by path before fetching and stored by the worker once their handler succeeded. Paths
+// must therefore identify immutable content, as the hashed file names of shadertoy.com media do. Offline, a cache miss fails
+// the request.
+class AssetDownloader final {
+public:
+    // Runs on a worker thread, returns an error message on failure
+    using Handler = std::function<std::optional<std::string>(const std::string& body)>;
+    // Runs on a worker thread before anything else, returns true if the request is already satisfied (e.g. from a cache of
+    // decoded data) and neither needs the body nor its handler
+    using Probe = std::function<bool()>;
+    using Headers = std::vector<std::pair<std::string, std::string>>;
+
+private:
+    struct Request final {
+        std::string path;
+        Handler handler;
+        Probe probe;
+    };
+
+    std::string mHost;
+    Headers mHeaders;
+    size_t mMaxConnections;
+    const DiskCache* mCache;  // optional
+    bool mOffline;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<Request> mQueue;
+    size_t mActive = 0;  // requests taken by a worker but not completed yet
+    bool mClosing = false;
+    std::atomic<bool> mCancelled{ false };  // aborts running transfers
+    std::vector<std::string> mErrors;
+    std::vector<std::thread> mWorkers;
+
+    void run();
+
+public:
+    AssetDownloader(std::string host, Headers headers, size_t maxConnections, const DiskCache* cache = nullptr,
+                    bool offline = false);
+    AssetDownloader(const AssetDownloader&) = delete;
+    AssetDownloader(AssetDownloader&&) = delete;
+    AssetDownloader& operator=(const AssetDownloader&) = delete;
+    AssetDownloader& operator=(AssetDownloader&&) = delete;
+    // drops the queued requests and waits for the running ones
+    ~AssetDownloader();
+
+    void enqueue(std::string path, Handler handler, Probe probe = nullptr);
+    // drops the queued requests and aborts the running transfers, which then fail
+    void cancel();
+    // blocks until all requests completed, returns the errors of failed requests
+    [[nodiscard]] std::vector<std::string> wait();
+};
+
+SHADERTOY_NAMESPACE_END
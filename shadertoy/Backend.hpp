@@ -15,7 +15,9 @@
 #pragma once
 #include "STTF.hpp"
 #include "shadertoy/Config.hpp"
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "shadertoy/SuppressWarningPush.hpp"
@@ -44,6 +46,21 @@ struct DoubleBufferedTex final {
     }
 };
 
+// Texels [x, x + width) x [y, y + height) of a dynamic texture
+struct TextureRegion final {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    [[nodiscard]] bool empty() const noexcept {
+        return width == 0 || height == 0;
+    }
+};
+// Updates the R8G8B8A8 texels in place and returns the bounding rect of the changes, or an empty region if nothing changed.
+// The texels persist between calls and start as zeros.
+using DynamicTextureUpdate = std::function<TextureRegion(uint32_t* data)>;
+
 struct ShaderToyUniform final {
     float time{};
     float timeDelta{};
@@ -76,6 +93,8 @@ public:
     virtual void bind(uint32_t width, uint32_t height) = 0;
     virtual void unbind() = 0;
     [[nodiscard]] virtual TextureId getTexture() const = 0;
+    [[nodiscard]] virtual size_t getMemoryUsage() const = 0;
+    virtual void clear() = 0;
 };
 struct DoubleBufferedFB final {
     FrameBuffer *t1, *t2;
@@ -88,6 +107,63 @@ struct DoubleBufferedFB final {
     }
 };
 
+// Offscreen color target for rendering without a window
+class RenderTarget {
+public:
+    RenderTarget() = default;
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget(RenderTarget&&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+    RenderTarget& operator=(RenderTarget&&) = delete;
+    virtual ~RenderTarget() = default;
+    virtual void bind() = 0;
+    virtual void unbind() = 0;
+    virtual void readPixels(uint32_t* data) const = 0;  // R8G8B8A8, bottom row first
+    [[nodiscard]] virtual ImVec2 size() const = 0;
+};
+
+// Pixels copied into a pixel buffer object, available once the GPU has finished the copy
+class PixelReadback {
+public:
+    PixelReadback() = default;
+    PixelReadback(const PixelReadback&) = delete;
+    PixelReadback(PixelReadback&&) = delete;
+    PixelReadback& operator=(const PixelReadback&) = delete;
+    PixelReadback& operator=(PixelReadback&&) = delete;
+    virtual ~PixelReadback() = default;
+    // never blocks, returns R8G8B8A8 pixels with the bottom row first once ready
+    [[nodiscard]] virtual std::optional<std::vector<uint32_t>> poll() = 0;
+    [[nodiscard]] virtual ImVec2 size() const = 0;
+};
+
+// Streams frames of a fixed size out of a render target through a ring of pixel buffer objects, so that the GPU can keep
+// rendering while earlier frames are copied
+class ReadbackRing {
+public:
+    ReadbackRing() = default;
+    ReadbackRing(const ReadbackRing&) = delete;
+    ReadbackRing(ReadbackRing&&) = delete;
+    ReadbackRing& operator=(const ReadbackRing&) = delete;
+    ReadbackRing& operator=(ReadbackRing&&) = delete;
+    virtual ~ReadbackRing() = default;
+    // starts copying the current contents of target, the ring must not be full
+    virtual void push(const RenderTarget& target) = 0;
+    // copies the oldest frame into data (R8G8B8A8, bottom row first). Returns false if the ring is empty, or if the frame is
+    // not ready yet and wait is false.
+    virtual bool pop(uint32_t* data, bool wait) = 0;
+    [[nodiscard]] virtual bool empty() const noexcept = 0;
+    [[nodiscard]] virtual bool full() const noexcept = 0;
+};
+
+struct PassStatistics final {
+    std::string name;
+    // GPU time in milliseconds over the recent frames
+    float mean;
+    float p50;
+    float p95;
+    float p99;
+};
+
 struct Channel final {  // NOLINT(cppcoreguidelines-pro-type-member-init)
     uint32_t slot;
     DoubleBufferedTex tex;
@@ -105,17 +181,52 @@ public:
     Pipeline& operator=(Pipeline&&) = delete;
     virtual ~Pipeline() = default;
 
-    virtual FrameBuffer* createFrameBuffer() = 0;
-    virtual std::vector<FrameBuffer*> createCubeMapFrameBuffer() = 0;
-    virtual void addPass(const std::string& src, NodeType type, std::vector<DoubleBufferedFB> target,
-                         std::vector<Channel> channels, bool clampOutput) = 0;
+    // preserveContents scales the contents of feedback buffers on resize instead of discarding them
+    virtual FrameBuffer* createFrameBuffer(Format format, bool preserveContents) = 0;
+    virtual FrameBuffer* createCubeMapFrameBuffer(Format format, uint32_t faceSize) = 0;
+    // signature identifies the pass across rebuilds, faceSize is only used by cube map passes
+    virtual void addPass(const std::string& name, uint64_t signature, const std::string& src, NodeType type, uint32_t faceSize,
+                         DoubleBufferedFB target, std::vector<Channel> channels, bool clampOutput) = 0;
+    // Incremental rebuilds. inherit() is called before adding passes: passes with the same final sources as a pass of previous
+    // share its program, and inheritFrameBuffers() returns the feedback buffers of the previous pass with the same name and
+    // signature. takeOver() must be called right before previous is replaced, so that the shared buffers continue from its
+    // latest frame.
+    virtual void inherit(const Pipeline& previous) = 0;
+    [[nodiscard]] virtual std::optional<DoubleBufferedFB> inheritFrameBuffers(const std::string& name, uint64_t signature) = 0;
+    virtual void takeOver(const Pipeline& previous) = 0;
+    // Passes are compiled asynchronously if the driver supports it. poll() never blocks and returns true once all passes are
+    // linked, link() waits for them. Both throw Error if a pass fails to compile; render() links first.
+    [[nodiscard]] virtual bool poll() = 0;
+    virtual void link() = 0;
     virtual void render(ImVec2 frameBufferSize, ImVec2 clipMin, ImVec2 clipMax, ImVec2 size, const ShaderToyUniform& uniform) = 0;
-    virtual TextureId createDynamicTexture(uint32_t width, uint32_t height, std::function<void(uint32_t*)> update) = 0;
+    // Like render(), but the final pass is rendered offscreen at captureSize pixels, read back asynchronously and scaled into the
+    // clip rect. Feedback buffers keep the canvas size and their contents.
+    [[nodiscard]] virtual std::unique_ptr<PixelReadback> capture(ImVec2 frameBufferSize, ImVec2 clipMin, ImVec2 clipMax,
+                                                                 ImVec2 size, const ShaderToyUniform& uniform,
+                                                                 ImVec2 captureSize) = 0;
+    // update is called once per frame, only the changed region is uploaded
+    virtual TextureId createDynamicTexture(uint32_t width, uint32_t height, DynamicTextureUpdate update) = 0;
+    [[nodiscard]] virtual std::vector<PassStatistics> getStatistics() = 0;
+    virtual void resetStatistics() = 0;
+    [[nodiscard]] virtual size_t getFrameBufferMemory() const = 0;
+    // Renders all passes at scale * the output size and upscales the final image, scale in (0, 1]. Feedback buffers are resampled
+    // with nearest filtering, which breaks shaders that store packed state at fixed texels.
+    virtual void setResolutionScale(float scale) = 0;
+    // GPU time of the latest measured frame in ms, 0 before the first measurement
+    [[nodiscard]] virtual float getGPUFrameTime() = 0;
+    // clears the contents of all frame buffers, e.g. to restart simulations deterministically
+    virtual void clearFrameBuffers() = 0;
 };
 
 std::unique_ptr<TextureObject> loadTexture(uint32_t width, uint32_t height, const uint32_t* data);
 std::unique_ptr<TextureObject> loadCubeMap(uint32_t size, const uint32_t* data);
+// decompressed to R8G8B8A8 if the driver cannot sample the block format
+std::unique_ptr<TextureObject> loadTexture(const CompressedImage& image);
+std::unique_ptr<TextureObject> loadCubeMap(const CompressedImage& image);
+[[nodiscard]] bool isTextureCompressionSupported();
 std::unique_ptr<TextureObject> loadVolume(uint32_t size, uint32_t channels, const uint8_t* data);
 std::unique_ptr<Pipeline> createPipeline();
+std::unique_ptr<RenderTarget> createRenderTarget(uint32_t width, uint32_t height);
+std::unique_ptr<ReadbackRing> createReadbackRing(uint32_t width, uint32_t height, uint32_t depth);
 
 SHADERTOY_NAMESPACE_END
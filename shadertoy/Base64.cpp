@@ -0,0 +1,194 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/Base64.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SHADERTOY_BASE64_SSSE3
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SHADERTOY_BASE64_NEON
+#include <arm_neon.h>
+#endif
+
+SHADERTOY_NAMESPACE_BEGIN
+
+static constexpr uint8_t invalidValue = 0xff;
+
+static constexpr std::array<uint8_t, 256> decodeTable = [] {
+    std::array<uint8_t, 256> table{};
+    for(auto& value : table)
+        value = invalidValue;
+    constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for(uint8_t idx = 0; idx < 64; ++idx)
+        table[static_cast<uint8_t>(alphabet[idx])] = idx;
+    return table;
+}();
+
+std::optional<size_t> base64DecodedSize(std::string_view src) {
+    if(src.size() % 4 == 0) {
+        for(int32_t padding = 0; padding < 2 && !src.empty() && src.back() == '='; ++padding)
+            src.remove_suffix(1);
+    }
+    if(src.size() % 4 == 1)
+        return std::nullopt;
+    return src.size() / 4 * 3 + (src.size() % 4 == 0 ? 0 : src.size() % 4 - 1);
+}
+
+// 4 characters -> 3 bytes, src and dst may be shorter for the last group
+static bool decodeScalar(const char* src, const size_t srcSize, uint8_t* dst, const size_t dstSize) {
+    size_t in = 0, out = 0;
+    while(out < dstSize) {
+        uint32_t group = 0;
+        uint32_t flags = 0;
+        for(size_t idx = 0; idx < 4; ++idx) {
+            const auto value = in + idx < srcSize ? decodeTable[static_cast<uint8_t>(src[in + idx])] : uint8_t{ 0 };
+            flags |= value;
+            group = group << 6 | value;
+        }
+        if(flags & 0xc0)  // invalidValue
+            return false;
+        const uint8_t bytes[3] = { static_cast<uint8_t>(group >> 16), static_cast<uint8_t>(group >> 8),
+                                   static_cast<uint8_t>(group) };
+        const auto count = dstSize - out < 3 ? dstSize - out : 3;
+        std::memcpy(dst + out, bytes, count);
+        in += 4;
+        out += count;
+    }
+    return true;
+}
+
+// Both SIMD paths translate characters by range instead of a table: each range (A-Z, a-z, 0-9, '+', '/') adds its own offset,
+// and anything outside of all ranges rejects the block, which is then left to the scalar path.
+#if defined(SHADERTOY_BASE64_SSSE3)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SHADERTOY_TARGET_SSSE3
+static bool hasSSSE3() {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+}
+#else
+#define SHADERTOY_TARGET_SSSE3 __attribute__((target("ssse3")))
+static bool hasSSSE3() {
+    return __builtin_cpu_supports("ssse3");
+}
+#endif
+
+// 16 characters -> 12 bytes, writes 16 bytes. Returns the number of consumed characters.
+SHADERTOY_TARGET_SSSE3 static size_t decodeSSSE3(const char* src, const size_t srcSize, uint8_t* dst, const size_t dstSize) {
+    const auto inRange = [](const __m128i chars, const char first, const char last) {
+        return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(first - 1))),
+                             _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(last + 1))));
+    };
+    size_t in = 0, out = 0;
+    while(in + 16 <= srcSize && out + 16 <= dstSize) {
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in));
+        const auto upper = inRange(chars, 'A', 'Z');
+        const auto lower = inRange(chars, 'a', 'z');
+        const auto digit = inRange(chars, '0', '9');
+        const auto plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+        const auto slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        const auto valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+        if(_mm_movemask_epi8(valid) != 0xffff)
+            break;
+        auto offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+        offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+        offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+        offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+        offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+        const auto values = _mm_add_epi8(chars, offset);
+        // [00aaaaaa 00bbbbbb 00cccccc 00dddddd] -> 24 bits per 32-bit lane, then drop the top byte of each lane
+        const auto pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const auto groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        const auto bytes = _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + out), bytes);
+        in += 16;
+        out += 12;
+    }
+    return in;
+}
+
+#elif defined(SHADERTOY_BASE64_NEON)
+
+// 64 characters -> 48 bytes. Returns the number of consumed characters.
+static size_t decodeNEON(const char* src, const size_t srcSize, uint8_t* dst, const size_t dstSize) {
+    const auto translate = [](const uint8x16_t chars, uint8x16_t& valid) {
+        const auto inRange = [&](const char first, const char last) {
+            return vandq_u8(vcgeq_u8(chars, vdupq_n_u8(static_cast<uint8_t>(first))),
+                            vcleq_u8(chars, vdupq_n_u8(static_cast<uint8_t>(last))));
+        };
+        const auto upper = inRange('A', 'Z');
+        const auto lower = inRange('a', 'z');
+        const auto digit = inRange('0', '9');
+        const auto plus = vceqq_u8(chars, vdupq_n_u8('+'));
+        const auto slash = vceqq_u8(chars, vdupq_n_u8('/'));
+        valid = vandq_u8(valid, vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, plus)), slash));
+        auto offset = vandq_u8(upper, vdupq_n_u8(static_cast<uint8_t>(-'A')));
+        offset = vorrq_u8(offset, vandq_u8(lower, vdupq_n_u8(static_cast<uint8_t>(26 - 'a'))));
+        offset = vorrq_u8(offset, vandq_u8(digit, vdupq_n_u8(static_cast<uint8_t>(52 - '0'))));
+        offset = vorrq_u8(offset, vandq_u8(plus, vdupq_n_u8(static_cast<uint8_t>(62 - '+'))));
+        offset = vorrq_u8(offset, vandq_u8(slash, vdupq_n_u8(static_cast<uint8_t>(63 - '/'))));
+        return vaddq_u8(chars, offset);
+    };
+    size_t in = 0, out = 0;
+    while(in + 64 <= srcSize && out + 48 <= dstSize) {
+        const auto chars = vld4q_u8(reinterpret_cast<const uint8_t*>(src + in));
+        auto valid = vdupq_n_u8(0xff);
+        const auto a = translate(chars.val[0], valid);
+        const auto b = translate(chars.val[1], valid);
+        const auto c = translate(chars.val[2], valid);
+        const auto d = translate(chars.val[3], valid);
+        if(vminvq_u8(valid) != 0xff)
+            break;
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(dst + out, bytes);
+        in += 64;
+        out += 48;
+    }
+    return in;
+}
+
+#endif
+
+bool base64Decode(const std::string_view src, uint8_t* dst) {
+    const auto size = base64DecodedSize(src);
+    if(!size)
+        return false;
+    size_t in = 0;
+#if defined(SHADERTOY_BASE64_SSSE3)
+    static const bool ssse3 = hasSSSE3();
+    if(ssse3)
+        in = decodeSSSE3(src.data(), src.size(), dst, *size);
+#elif defined(SHADERTOY_BASE64_NEON)
+    in = decodeNEON(src.data(), src.size(), dst, *size);
+#endif
+    const auto out = in / 4 * 3;
+    auto rest = src.substr(in);
+    // padding is only stripped where base64DecodedSize accepted it, any other '=' is an invalid character
+    for(int32_t padding = 0; padding < 2 && src.size() % 4 == 0 && !rest.empty() && rest.back() == '='; ++padding)
+        rest.remove_suffix(1);
+    return decodeScalar(rest.data(), rest.size(), dst + out, *size - out);
+}
+
+SHADERTOY_NAMESPACE_END
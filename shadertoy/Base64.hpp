@@ -0,0 +1,29 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Config.hpp"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+// Standard base64 alphabet, padding is optional. Returns nullopt if the length is not valid.
+std::optional<size_t> base64DecodedSize(std::string_view src);
+// Writes exactly base64DecodedSize(src) bytes into dst. Returns false on characters outside of the alphabet, without
+// whitespace skipping. Uses SSSE3 or NEON when available.
+[[nodiscard]] bool base64Decode(std::string_view src, uint8_t* dst);
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,313 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/BlockCompression.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#define STB_DXT_STATIC
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+static constexpr uint32_t blockDim = 4;
+
+static uint32_t getBlockBytes(const BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+static uint32_t nextLevel(const uint32_t size) {
+    return std::max(size >> 1, 1U);
+}
+
+uint32_t getMipLevels(const uint32_t width, const uint32_t height) {
+    uint32_t levels = 1;
+    for(auto size = std::max(width, height); size > 1; size >>= 1)
+        ++levels;
+    return levels;
+}
+
+size_t getCompressedLevelSize(const BlockFormat format, const uint32_t width, const uint32_t height) {
+    return static_cast<size_t>((width + blockDim - 1) / blockDim) * ((height + blockDim - 1) / blockDim) * getBlockBytes(format);
+}
+
+static size_t getMipChainSize(const BlockFormat format, const uint32_t width, const uint32_t height) {
+    size_t size = 0;
+    const auto levels = getMipLevels(width, height);
+    for(uint32_t level = 0, w = width, h = height; level < levels; ++level, w = nextLevel(w), h = nextLevel(h))
+        size += getCompressedLevelSize(format, w, h);
+    return size;
+}
+
+size_t getCompressedSize(const BlockFormat format, const uint32_t width, const uint32_t height, const uint32_t faces) {
+    return getMipChainSize(format, width, height) * faces;
+}
+
+// Threads shared by all compressions. One loop runs at a time and the calling thread takes part in it.
+class WorkerPool final {
+    std::mutex mLoopMutex;  // serializes loops
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    const std::function<void(size_t)>* mFunc = nullptr;  // null between loops
+    size_t mCount = 0;
+    std::atomic<size_t> mNext{ 0 };
+    size_t mBusy = 0;  // workers inside the current loop
+    uint64_t mLoop = 0;
+    bool mStopping = false;
+    std::vector<std::thread> mWorkers;
+
+    void runLoop(const std::function<void(size_t)>& func, const size_t count) {
+        for(auto idx = mNext++; idx < count; idx = mNext++)
+            func(idx);
+    }
+    void work() {
+        uint64_t seen = 0;
+        while(true) {
+            const std::function<void(size_t)>* func;
+            size_t count;
+            {
+                std::unique_lock lock{ mMutex };
+                mWake.wait(lock, [&] { return mStopping || mLoop != seen; });
+                if(mStopping)
+                    return;
+                seen = mLoop;
+                // woken too late, the loop already finished
+                if(!mFunc)
+                    continue;
+                func = mFunc;
+                count = mCount;
+                ++mBusy;
+            }
+            runLoop(*func, count);
+            {
+                std::lock_guard lock{ mMutex };
+                --mBusy;
+            }
+            mDone.notify_all();
+        }
+    }
+
+public:
+    WorkerPool() {
+        for(uint32_t idx = 1; idx < std::max(std::thread::hardware_concurrency(), 1U); ++idx)
+            mWorkers.emplace_back([this] { work(); });
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+    ~WorkerPool() {
+        {
+            std::lock_guard lock{ mMutex };
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for(auto& worker : mWorkers)
+            worker.join();
+    }
+
+    // runs func(0), ..., func(count - 1)
+    void parallelFor(const size_t count, const std::function<void(size_t)>& func) {
+        std::lock_guard loop{ mLoopMutex };
+        {
+            std::lock_guard lock{ mMutex };
+            mFunc = &func;
+            mCount = count;
+            mNext = 0;
+            ++mLoop;
+        }
+        mWake.notify_all();
+        runLoop(func, count);
+        std::unique_lock lock{ mMutex };
+        mDone.wait(lock, [&] { return mBusy == 0; });
+        mFunc = nullptr;
+    }
+};
+
+static void parallelFor(const size_t count, const std::function<void(size_t)>& func) {
+    static WorkerPool pool;
+    pool.parallelFor(count, func);
+}
+
+static uint32_t channel(const uint32_t pixel, const uint32_t shift) {
+    return (pixel >> shift) & 0xff;
+}
+
+// 2x2 box filter, the last row or column is repeated for odd sizes
+static std::vector<uint32_t> downsample(const uint32_t* src, const uint32_t width, const uint32_t height) {
+    const auto w = nextLevel(width), h = nextLevel(height);
+    std::vector<uint32_t> dst(static_cast<size_t>(w) * h);
+    for(uint32_t y = 0; y < h; ++y) {
+        const auto row0 = src + static_cast<size_t>(std::min(y * 2, height - 1)) * width;
+        const auto row1 = src + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width;
+        for(uint32_t x = 0; x < w; ++x) {
+            const auto x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            uint32_t pixel = 0;
+            for(uint32_t shift = 0; shift < 32; shift += 8) {
+                const auto sum = channel(row0[x0], shift) + channel(row0[x1], shift) + channel(row1[x0], shift) +
+                    channel(row1[x1], shift);
+                pixel |= ((sum + 2) / 4) << shift;
+            }
+            dst[static_cast<size_t>(y) * w + x] = pixel;
+        }
+    }
+    return dst;
+}
+
+static std::array<uint32_t, 3> fromRGB565(const uint16_t color) {
+    const uint32_t r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+    return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+static void encodeBlockRow(const BlockFormat format, const uint32_t* src, const uint32_t width, const uint32_t height,
+                           const uint32_t row, uint8_t* dst) {
+    const auto blocks = (width + blockDim - 1) / blockDim;
+    uint32_t block[16];
+    for(uint32_t bx = 0; bx < blocks; ++bx) {
+        // edge blocks repeat the last row and column
+        for(uint32_t y = 0; y < blockDim; ++y) {
+            const auto line = src + static_cast<size_t>(std::min(row * blockDim + y, height - 1)) * width;
+            for(uint32_t x = 0; x < blockDim; ++x)
+                block[y * blockDim + x] = line[std::min(bx * blockDim + x, width - 1)];
+        }
+        // R8G8B8A8 pixels are the RGBA bytes stb_dxt expects, BC3 blocks are the alpha block followed by the color block
+        stb_compress_dxt_block(dst, reinterpret_cast<const unsigned char*>(block), format == BlockFormat::BC3 ? 1 : 0,
+                               STB_DXT_HIGHQUAL);
+        dst += getBlockBytes(format);
+    }
+}
+
+CompressedImage compressImage(const uint32_t width, const uint32_t height, const uint32_t faces, const uint32_t* pixels) {
+    const auto facePixels = static_cast<size_t>(width) * height;
+    const auto opaque =
+        std::all_of(pixels, pixels + facePixels * faces, [](const uint32_t pixel) { return pixel >= 0xff000000; });
+    const auto format = opaque ? BlockFormat::BC1 : BlockFormat::BC3;
+    const auto levels = getMipLevels(width, height);
+
+    // mip chains of all faces, level 0 refers to the input
+    std::vector<std::vector<std::vector<uint32_t>>> chains(faces);
+    parallelFor(faces, [&](const size_t face) {
+        auto& chain = chains[face];
+        const uint32_t* src = pixels + face * facePixels;
+        for(uint32_t level = 1, w = width, h = height; level < levels; ++level, w = nextLevel(w), h = nextLevel(h)) {
+            chain.push_back(downsample(src, w, h));
+            src = chain.back().data();
+        }
+    });
+
+    struct RowTask final {
+        const uint32_t* src;
+        uint32_t width;
+        uint32_t height;
+        uint32_t row;
+        uint8_t* dst;
+    };
+    CompressedImage image{ format, width, height, faces, std::vector<uint8_t>(getCompressedSize(format, width, height, faces)) };
+    std::vector<RowTask> tasks;
+    auto dst = image.data.data();
+    for(uint32_t face = 0; face < faces; ++face) {
+        for(uint32_t level = 0, w = width, h = height; level < levels; ++level, w = nextLevel(w), h = nextLevel(h)) {
+            const auto src = level == 0 ? pixels + face * facePixels : chains[face][level - 1].data();
+            const auto rows = (h + blockDim - 1) / blockDim;
+            const auto rowBytes = getCompressedLevelSize(format, w, blockDim);
+            for(uint32_t row = 0; row < rows; ++row)
+                tasks.push_back(RowTask{ src, w, h, row, dst + row * rowBytes });
+            dst += getCompressedLevelSize(format, w, h);
+        }
+    }
+    parallelFor(tasks.size(), [&](const size_t idx) {
+        const auto& task = tasks[idx];
+        encodeBlockRow(format, task.src, task.width, task.height, task.row, task.dst);
+    });
+    return image;
+}
+
+static void decodeBlock(const BlockFormat format, const uint8_t* src, uint32_t* block) {
+    std::array<uint32_t, 8> alphaPalette{};
+    uint64_t alphaIndices = 0;
+    if(format == BlockFormat::BC3) {
+        const uint32_t a0 = src[0], a1 = src[1];
+        alphaPalette[0] = a0;
+        alphaPalette[1] = a1;
+        if(a0 > a1) {
+            for(uint32_t idx = 1; idx < 7; ++idx)
+                alphaPalette[idx + 1] = ((7 - idx) * a0 + idx * a1) / 7;
+        } else {
+            for(uint32_t idx = 1; idx < 5; ++idx)
+                alphaPalette[idx + 1] = ((5 - idx) * a0 + idx * a1) / 5;
+            alphaPalette[6] = 0;
+            alphaPalette[7] = 255;
+        }
+        for(uint32_t idx = 0; idx < 6; ++idx)
+            alphaIndices |= static_cast<uint64_t>(src[2 + idx]) << (idx * 8);
+        src += 8;
+    }
+    const auto c0 = static_cast<uint16_t>(src[0] | src[1] << 8);
+    const auto c1 = static_cast<uint16_t>(src[2] | src[3] << 8);
+    const auto indices = static_cast<uint32_t>(src[4] | src[5] << 8 | src[6] << 16) | static_cast<uint32_t>(src[7]) << 24;
+    const auto p0 = fromRGB565(c0), p1 = fromRGB565(c1);
+    std::array<uint32_t, 4> palette{};
+    const auto fourColors = format == BlockFormat::BC3 || c0 > c1;
+    for(uint32_t c = 0; c < 3; ++c) {
+        palette[0] |= p0[c] << (c * 8);
+        palette[1] |= p1[c] << (c * 8);
+        palette[2] |= (fourColors ? (2 * p0[c] + p1[c]) / 3 : (p0[c] + p1[c]) / 2) << (c * 8);
+        if(fourColors)
+            palette[3] |= ((p0[c] + 2 * p1[c]) / 3) << (c * 8);
+    }
+    for(uint32_t idx = 0; idx < 4; ++idx)
+        palette[idx] |= fourColors || idx != 3 ? 0xff000000 : 0;  // BC1 punch-through alpha
+    for(uint32_t idx = 0; idx < 16; ++idx) {
+        auto pixel = palette[(indices >> (idx * 2)) & 3];
+        if(format == BlockFormat::BC3)
+            pixel = (pixel & 0xffffff) | alphaPalette[(alphaIndices >> (idx * 3)) & 7] << 24;
+        block[idx] = pixel;
+    }
+}
+
+std::vector<uint32_t> decompressImage(const CompressedImage& image) {
+    const auto width = image.width, height = image.height;
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height * image.faces);
+    const auto chainSize = getMipChainSize(image.format, width, height);
+    const auto blocksX = (width + blockDim - 1) / blockDim, blocksY = (height + blockDim - 1) / blockDim;
+    uint32_t block[16];
+    for(uint32_t face = 0; face < image.faces; ++face) {
+        auto src = image.data.data() + face * chainSize;
+        const auto dst = pixels.data() + static_cast<size_t>(face) * width * height;
+        for(uint32_t by = 0; by < blocksY; ++by) {
+            for(uint32_t bx = 0; bx < blocksX; ++bx) {
+                decodeBlock(image.format, src, block);
+                src += getBlockBytes(image.format);
+                for(uint32_t y = 0; y < blockDim && by * blockDim + y < height; ++y) {
+                    for(uint32_t x = 0; x < blockDim && bx * blockDim + x < width; ++x)
+                        dst[static_cast<size_t>(by * blockDim + y) * width + bx * blockDim + x] = block[y * blockDim + x];
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,44 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+enum class BlockFormat { BC1, BC3 };  // a.k.a. DXT1 (opaque) and DXT5
+
+// Complete mip chains of one or six (cube map) square or rectangular faces, face after face and largest level first
+struct CompressedImage final {
+    BlockFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t faces;
+    std::vector<uint8_t> data;
+};
+
+[[nodiscard]] uint32_t getMipLevels(uint32_t width, uint32_t height);
+// of one level, in bytes
+[[nodiscard]] size_t getCompressedLevelSize(BlockFormat format, uint32_t width, uint32_t height);
+// of the mip chains of all faces, in bytes
+[[nodiscard]] size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height, uint32_t faces);
+// pixels holds the R8G8B8A8 level 0 of each face. BC1 is chosen if all pixels are opaque. Blocks are encoded on all cores.
+[[nodiscard]] CompressedImage compressImage(uint32_t width, uint32_t height, uint32_t faces, const uint32_t* pixels);
+// level 0 of each face as R8G8B8A8, for drivers without S3TC support
+[[nodiscard]] std::vector<uint32_t> decompressImage(const CompressedImage& image);
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,194 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/DiskCache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <hello_imgui/hello_imgui.h>
+
+#if defined(SHADERTOY_WINDOWS)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+uint64_t hashString(const std::string_view str, uint64_t seed) {
+    for(const auto ch : str) {
+        seed ^= static_cast<uint8_t>(ch);
+        seed *= 0x100000001b3ULL;
+    }
+    return seed;
+}
+
+struct DiskCacheHeader final {
+    static constexpr uint32_t magicValue = 0x43545453;  // STTC
+
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t size;
+};
+
+static std::filesystem::path getCacheRoot() {
+#if defined(SHADERTOY_WINDOWS)
+    if(const auto localAppData = std::getenv("LOCALAPPDATA"))  // NOLINT(concurrency-mt-unsafe)
+        return std::filesystem::path{ localAppData } / "shadertoy";
+#elif defined(SHADERTOY_MACOS)
+    if(const auto home = std::getenv("HOME"))  // NOLINT(concurrency-mt-unsafe)
+        return std::filesystem::path{ home } / "Library" / "Caches" / "shadertoy";
+#else
+    if(const auto cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)  // NOLINT(concurrency-mt-unsafe)
+        return std::filesystem::path{ cacheHome } / "shadertoy";
+    if(const auto home = std::getenv("HOME"))  // NOLINT(concurrency-mt-unsafe)
+        return std::filesystem::path{ home } / ".cache" / "shadertoy";
+#endif
+    return {};
+}
+
+DiskCache::DiskCache(const std::string_view name, const uintmax_t capacity) : mCapacity{ capacity } {
+    const auto root = getCacheRoot();
+    if(root.empty())
+        return;
+    auto directory = root / name;
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if(ec) {
+        HelloImGui::Log(HelloImGui::LogLevel::Warning, "Cannot create cache directory %s: %s", directory.string().c_str(),
+                        ec.message().c_str());
+        return;
+    }
+    mDirectory = std::move(directory);
+    mSize = evict();
+}
+
+std::filesystem::path DiskCache::getPath(const uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return mDirectory / name;
+}
+
+std::optional<std::vector<uint8_t>> DiskCache::load(const uint64_t key) const {
+    if(!isAvailable())
+        return std::nullopt;
+    const auto path = getPath(key);
+    std::ifstream file{ path, std::ios::binary };
+    if(!file)
+        return std::nullopt;
+    DiskCacheHeader header{};
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != DiskCacheHeader::magicValue ||
+       header.key != key)
+        return std::nullopt;
+    // a damaged entry must not request an arbitrary allocation
+    std::error_code ec;
+    if(const auto fileSize = std::filesystem::file_size(path, ec); ec || header.size != fileSize - sizeof(header))
+        return std::nullopt;
+    std::vector<uint8_t> data(static_cast<size_t>(header.size));
+    if(!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())))
+        return std::nullopt;
+    file.close();
+
+    // the modification time doubles as the last access time for eviction
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return data;
+}
+
+bool DiskCache::store(const uint64_t key, const uint8_t* data, const size_t size) const {
+    if(!isAvailable())
+        return true;
+    const auto path = getPath(key);
+    // unique per process and thread, so that concurrent stores of the same key never write into the same file
+#if defined(SHADERTOY_WINDOWS)
+    const auto processId = static_cast<unsigned long long>(_getpid());
+#else
+    const auto processId = static_cast<unsigned long long>(getpid());
+#endif
+    char suffix[48];
+    std::snprintf(suffix, sizeof(suffix), ".%llx.%zx.tmp", processId, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    auto tmpPath = path;
+    tmpPath += suffix;
+    {
+        std::ofstream file{ tmpPath, std::ios::binary };
+        const DiskCacheHeader header{ DiskCacheHeader::magicValue, 0, key, size };
+        if(!file || !file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+           !file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size)))
+            return false;
+    }
+    std::error_code ec;
+    const auto replaced = std::filesystem::file_size(path, ec);
+    const auto replacedSize = ec ? 0 : replaced;
+    // readers never observe partially written entries
+    std::filesystem::rename(tmpPath, path, ec);
+    if(ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    std::lock_guard lock{ mMutex };
+    mSize = mSize - std::min(mSize, replacedSize) + sizeof(DiskCacheHeader) + size;
+    if(mSize > mCapacity)
+        mSize = evict();
+    return true;
+}
+
+uintmax_t DiskCache::evict() const {
+    struct Entry final {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code ec;
+    // temporaries older than any store in progress were left behind by a crash
+    const auto staleTime = std::filesystem::file_time_type::clock::now() - std::chrono::minutes(1);
+    for(auto& entry : std::filesystem::directory_iterator{ mDirectory, ec }) {
+        if(!entry.is_regular_file(ec))
+            continue;
+        if(entry.path().extension() == ".tmp") {
+            if(const auto time = entry.last_write_time(ec); !ec && time < staleTime)
+                std::filesystem::remove(entry.path(), ec);
+            continue;
+        }
+        if(entry.path().extension() != ".bin")
+            continue;
+        const auto size = entry.file_size(ec);
+        if(ec)
+            continue;
+        total += size;
+        entries.push_back(Entry{ entry.path(), entry.last_write_time(ec), size });
+    }
+    if(total <= mCapacity)
+        return total;
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.time < rhs.time; });
+    for(auto& [path, time, size] : entries) {
+        if(total <= mCapacity)
+            break;
+        if(std::filesystem::remove(path, ec))
+            total -= size;
+    }
+    return total;
+}
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,52 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Config.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+// 64-bit FNV-1a, chain calls through seed to hash several strings
+uint64_t hashString(std::string_view str, uint64_t seed = 0xcbf29ce484222325ULL);
+
+// Blobs keyed by a 64-bit hash, stored under the user cache directory. Least recently used entries are evicted once the
+// total size exceeds the capacity. Failures behave like misses. Only the constructor logs, loads and stores may run on worker
+// threads.
+class DiskCache final {
+    std::filesystem::path mDirectory;  // empty if unavailable
+    uintmax_t mCapacity;
+    mutable std::mutex mMutex;
+    mutable uintmax_t mSize = 0;  // of all entries, only rescanned by the constructor and when over capacity
+
+    [[nodiscard]] std::filesystem::path getPath(uint64_t key) const;
+    // removes the least recently used entries until the total size fits, returns the remaining size
+    [[nodiscard]] uintmax_t evict() const;
+
+public:
+    DiskCache(std::string_view name, uintmax_t capacity);
+    [[nodiscard]] bool isAvailable() const noexcept {
+        return !mDirectory.empty();
+    }
+    [[nodiscard]] std::optional<std::vector<uint8_t>> load(uint64_t key) const;
+    // returns false if the entry cannot be written, an unavailable cache was already reported by the constructor
+    bool store(uint64_t key, const uint8_t* data, size_t size) const;
+};
+
+SHADERTOY_NAMESPACE_END
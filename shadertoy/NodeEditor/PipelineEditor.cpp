@@ -12,12 +12,9 @@
     limitations under the License.
 */
 
-#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
-#define CPPHTTPLIB_OPENSSL_SUPPORT
-#endif
-
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include "shadertoy/NodeEditor/PipelineEditor.hpp"
+#include <algorithm>
 #include <queue>
 
 #include "shadertoy/SuppressWarningPush.hpp"
@@ -26,11 +23,9 @@
 #include <hello_imgui/dpi_aware.h>
 #include <hello_imgui/hello_imgui.h>
 #include <hello_imgui/image_from_asset.h>
-#include <httplib.h>
 #include <imgui/misc/cpp/imgui_stdlib.h>
 #include <magic_enum.hpp>
 #include <nfd.h>
-#include <nlohmann/json.hpp>
 #include <stb_image.h>
 
 using HelloImGui::EmToVec2;
@@ -59,11 +54,12 @@ void ShaderToyEditor::setText(const std::string& str) {
     mEditor.SetText(str);
 }
 
-void ShaderToyEditor::render(const ImVec2 size) {
+bool ShaderToyEditor::render(const ImVec2 size) {
     const auto cpos = mEditor.GetCursorPosition();
     ImGui::Text("%6d/%-6d %6d lines  %s", cpos.mLine + 1, cpos.mColumn + 1, mEditor.GetTotalLines(),
                 mEditor.IsOverwrite() ? "Ovr" : "Ins");
     mEditor.Render("TextEditor", size, false);
+    return mEditor.IsTextChanged();
 }
 
 static constexpr auto initialShader = R"(void mainImage( out vec4 fragColor, in vec2 fragCoord )
@@ -79,23 +75,6 @@ static constexpr auto initialShader = R"(void mainImage( out vec4 fragColor, in
 }
 )";
 
-static constexpr auto initialCubeMap =
-    R"(void mainCubemap( out vec4 fragColor, in vec2 fragCoord, in vec3 rayOri, in vec3 rayDir )
-{
-    // Ray direction as color
-    vec3 col = 0.5 + 0.5*rayDir;
-
-    // Output to cubemap
-    fragColor = vec4(col,1.0);
-}
-)";
-
-static constexpr auto initialBuffer = R"(void mainImage( out vec4 fragColor, in vec2 fragCoord )
-{
-    fragColor = vec4(0.0,0.0,1.0,1.0);
-}
-)";
-
 uint32_t PipelineEditor::nextId() {
     return mNextId++;
 }
@@ -118,11 +97,16 @@ PipelineEditor::PipelineEditor() {
     mShouldResetLayout = true;
 }
 void PipelineEditor::resetPipeline() {
+    mPendingSTTF.reset();
+    mPendingImport.reset();
+    for(auto& node : mNodes)
+        retireNode(*node);
     mNodes.clear();
     mLinks.clear();
     mMetadata.clear();
     setupInitialPipeline();
     mShouldBuildPipeline = true;
+    mInheritState = false;
     mShouldResetLayout = true;
 }
 
@@ -381,9 +365,26 @@ void PipelineEditor::renderEditor() {
         }
     }
 
+    float totalTime = 0.0f;
+    for(auto& stats : mStatistics)
+        totalTime += stats.mean;
+    const auto findStatistics = [&](const EditorNode& node) -> const PassStatistics* {
+        for(auto& stats : mStatistics)
+            if(stats.name == node.name)
+                return &stats;
+        return nullptr;
+    };
+
     for(auto& node : mNodes) {
+        const auto stats = node->getClass() == NodeClass::GLSLShader ? findStatistics(*node) : nullptr;
         builder.begin(node->id);
-        builder.header(node->color);
+        if(stats && totalTime > 0.0f) {
+            // tint expensive passes towards red
+            const auto ratio = stats->mean / totalTime;
+            const auto& base = node->color.Value;
+            builder.header(ImVec4{ base.x + (1.0f - base.x) * ratio, base.y * (1.0f - ratio), base.z * (1.0f - ratio), base.w });
+        } else
+            builder.header(node->color);
         ImGui::Spring(0);
         if(node->rename) {
             if(ImGui::InputText("##Name", &node->name, ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CharsNoBlank)) {
@@ -395,6 +396,10 @@ void PipelineEditor::renderEditor() {
             }
         } else
             ImGui::TextUnformatted(node->name.c_str());
+        if(stats) {
+            ImGui::Spring(0);
+            ImGui::Text("%.2f ms", static_cast<double>(stats->mean));
+        }
         ImGui::Spring(1);
         ImGui::Dummy(EmToVec2(0, 1.5));
         ImGui::Spring(0);
@@ -565,6 +570,7 @@ void PipelineEditor::renderEditor() {
                                                         return (u->node == id->get() || v->node == id->get());
                                                     }),
                                      mLinks.end());
+                        retireNode(**id);
                         mNodes.erase(id);
                     }
                 }
@@ -659,7 +665,7 @@ void PipelineEditor::renderEditor() {
     ed::End();
 }
 
-static void setupKeyboardData(uint32_t* data) {
+static TextureRegion setupKeyboardData(uint32_t* data) {
     // See also
     // https://shadertoyunofficial.wordpress.com/2016/07/20/special-shadertoy-features/
     // FIXME: remapping keys
@@ -755,214 +761,155 @@ static void setupKeyboardData(uint32_t* data) {
         { 220, ImGuiKey_Backslash },
         { 221, ImGuiKey_RightBracket },
     };
-    auto getKey = [&](int32_t x, int32_t y) -> uint32_t& { return data[x + y * 256]; };
+    // most frames change nothing, so only the bounding rect of the changed keys is reported
+    uint32_t minX = 256, maxX = 0, minY = 3, maxY = 0;
+    auto setKey = [&](const int32_t idx, const uint32_t y, const uint32_t value) {
+        const auto x = static_cast<uint32_t>(idx);
+        auto& texel = data[x + y * 256];
+        if(texel == value)
+            return;
+        texel = value;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    };
     for(auto [idx, key] : mapping) {
         const auto down = ImGui::IsKeyDown(key);
         const auto pressed = ImGui::IsKeyPressed(key, false);
         constexpr uint32_t mask = 0xffffffff;
-        getKey(idx, 0) = down ? mask : 0;
-        getKey(idx, 1) = pressed ? mask : 0;
+        setKey(idx, 0, down ? mask : 0);
+        setKey(idx, 1, pressed ? mask : 0);
         if(pressed)
-            getKey(idx, 2) ^= mask;
+            setKey(idx, 2, data[idx + 2 * 256] ^ mask);
     }
+    if(minX > maxX)
+        return TextureRegion{};
+    return TextureRegion{ minX, minY, maxX - minX + 1, maxY - minY + 1 };
 }
 
-std::unique_ptr<Pipeline> PipelineEditor::buildPipeline() {
-    std::unordered_map<EditorNode*, std::vector<std::tuple<EditorNode*, uint32_t, EditorLink*>>> graph;
-    EditorNode* directRenderNode = nullptr;
-    std::unordered_map<EditorNode*, uint32_t> degree;
-    EditorNode* sinkNode = nullptr;
-    for(auto& link : mLinks) {
-        auto u = findPin(link.startPinId);
-        auto v = findPin(link.endPinId);
-        auto idx = static_cast<uint32_t>(v - v->node->inputs.data());
-        graph[v->node].emplace_back(u->node, idx, &link);
-        ++degree[u->node];
-        if(v->node->getClass() == NodeClass::RenderOutput && u->node->getClass() == NodeClass::GLSLShader) {
-            sinkNode = v->node;
-            directRenderNode = u->node;
-        }
-    }
-
-    if(!sinkNode) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Exactly one shader should be connected to the final render output");
-        throw Error{};
-    }
-
-    std::unordered_set<EditorNode*> visited;
-    std::queue<EditorNode*> q;
-    std::vector<EditorNode*> order;
-    q.push(sinkNode);
-    std::unordered_set<EditorNode*> weakRef;
+PipelineDesc PipelineEditor::describePipeline() const {
+    PipelineDesc desc;
+    std::unordered_map<const EditorNode*, uint32_t> nodeMap;
     for(auto& node : mNodes) {
-        if(node->getClass() == NodeClass::LastFrame) {
-            weakRef.insert(dynamic_cast<EditorLastFrame*>(node.get())->lastFrame);
-        }
-    }
-    for(auto node : weakRef) {
-        if(!degree.count(node))
-            q.push(node);
-    }
-    while(!q.empty()) {
-        auto u = q.front();
-        q.pop();
-        visited.insert(u);
-        order.push_back(u);
-
-        if(auto it = graph.find(u); it != graph.cend()) {
-            for(auto [v, idx, link] : it->second) {
-                visited.insert(v);
-                if(--degree[v] == 0) {
-                    q.push(v);
-                }
-            }
-        }
-    }
-
-    if(visited.size() != order.size()) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Loop detected");
-        throw Error{};
-    }
-
-    std::reverse(order.begin(), order.end());
-
-    auto pipeline = createPipeline();
-    std::unordered_map<EditorNode*, DoubleBufferedTex> textureMap;
-    std::unordered_map<EditorNode*, ImVec2> textureSizeMap;
-    std::unordered_map<EditorNode*, std::vector<DoubleBufferedFB>> frameBufferMap;
-    std::unordered_set<EditorNode*> requireDoubleBuffer;
-    for(auto node : order) {
-        if(node->getClass() == NodeClass::LastFrame) {
-            auto ref = dynamic_cast<EditorLastFrame&>(*node).lastFrame;
-            if(!ref || ref == directRenderNode) {
-                HelloImGui::Log(HelloImGui::LogLevel::Error, "Invalid reference");
-                throw Error{};
-            }
-            requireDoubleBuffer.insert(ref);
-        }
-    }
-    // TODO: FB allocation
-    for(auto node : order) {
-        if(node->getClass() == NodeClass::GLSLShader) {
-            if(node->type == NodeType::Image) {
-                DoubleBufferedFB frameBuffer{ nullptr };
-                if(requireDoubleBuffer.count(node)) {
-                    auto t1 = pipeline->createFrameBuffer();
-                    auto t2 = pipeline->createFrameBuffer();
-                    frameBuffer = DoubleBufferedFB{ t1, t2 };
-                } else if(node != directRenderNode) {
-                    auto t = pipeline->createFrameBuffer();
-                    frameBuffer = DoubleBufferedFB{ t };
-                }
-                frameBufferMap.emplace(node, std::vector<DoubleBufferedFB>{ frameBuffer });
-            } else if(node->type == NodeType::CubeMap) {
-                std::vector<DoubleBufferedFB> buffers;
-                buffers.reserve(6);
-                if(requireDoubleBuffer.count(node)) {
-                    auto t1 = pipeline->createCubeMapFrameBuffer();
-                    auto t2 = pipeline->createCubeMapFrameBuffer();
-                    for(uint32_t idx = 0; idx < 6; ++idx)
-                        buffers.emplace_back(t1[idx], t2[idx]);
-                } else {
-                    assert(node != directRenderNode);
-                    auto t = pipeline->createCubeMapFrameBuffer();
-                    for(uint32_t idx = 0; idx < 6; ++idx)
-                        buffers.emplace_back(t[idx]);
-                }
-                frameBufferMap.emplace(node, std::move(buffers));
-            } else {
-                HelloImGui::Log(HelloImGui::LogLevel::Error, "Unsupported shader type");
-                throw Error{};
-            }
-        }
-    }
-
-    for(auto node : order) {
+        nodeMap.emplace(node.get(), static_cast<uint32_t>(desc.nodes.size()));
+        auto& descNode = desc.nodes.emplace_back();
+        descNode.name = node->name;
+        descNode.nodeClass = node->getClass();
+        descNode.type = node->type;
         switch(node->getClass()) {  // NOLINT(clang-diagnostic-switch-enum)
             case NodeClass::GLSLShader: {
-                auto& target = frameBufferMap.at(node);
-                std::vector<Channel> channels;
-                if(auto it = graph.find(node); it != graph.cend()) {
-                    for(auto [v, idx, link] : it->second) {
-                        std::optional<ImVec2> size = std::nullopt;
-                        if(auto iter = textureSizeMap.find(v); iter != textureSizeMap.cend())
-                            size = iter->second;
-                        channels.push_back(Channel{ idx, textureMap.at(v), link->filter, link->wrapMode, size });
-                    }
-                }
-                // TODO: error markers
-                auto guard = scopeFail(
-                    [&] { HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to compile shader %s", node->name.c_str()); });
-                pipeline->addPass(dynamic_cast<EditorShader*>(node)->editor.getText(), node->type, target, std::move(channels),
-                                  node == sinkNode);
-
-                if(target.front().t1) {
-                    auto texType = node->type == NodeType::CubeMap ? TexType::CubeMap : TexType::Tex2D;
-
-                    textureMap.emplace(
-                        node, DoubleBufferedTex{ target.front().t1->getTexture(), target.front().t2->getTexture(), texType });
-                }
-
+                const auto& shader = dynamic_cast<const EditorShader&>(*node);
+                descNode.source = shader.editor.getText();
+                descNode.format = shader.format;
+                descNode.faceSize = shader.faceSize;
                 break;
             }
-            case NodeClass::LastFrame: {
-                const auto ref = dynamic_cast<EditorLastFrame*>(node)->lastFrame;
-                auto target = frameBufferMap.at(ref).front();
-                assert(target.t1 && target.t2);
-                textureMap.emplace(node,
-                                   DoubleBufferedTex{ target.t2->getTexture(), target.t1->getTexture(),
-                                                      ref->type == NodeType::CubeMap ? TexType::CubeMap : TexType::Tex2D });
+            case NodeClass::Texture:
+                descNode.texture = dynamic_cast<const EditorTexture&>(*node).textureId.get();
                 break;
-            }
-            case NodeClass::RenderOutput: {
+            case NodeClass::CubeMap:
+                descNode.texture = dynamic_cast<const EditorCubeMap&>(*node).textureId.get();
                 break;
-            }
-            case NodeClass::Texture: {
-                auto& textureId = dynamic_cast<EditorTexture*>(node)->textureId;
-                textureSizeMap.emplace(node, textureId->size());
-                textureMap.emplace(node, DoubleBufferedTex{ textureId->getTexture(), TexType::Tex2D });
+            case NodeClass::Volume:
+                descNode.texture = dynamic_cast<const EditorVolume&>(*node).textureId.get();
                 break;
-            }
-            case NodeClass::CubeMap: {
-                auto& textureId = dynamic_cast<EditorCubeMap*>(node)->textureId;
-                textureSizeMap.emplace(node, textureId->size());
-                textureMap.emplace(node, DoubleBufferedTex{ textureId->getTexture(), TexType::CubeMap });
-                break;
-            }
-            case NodeClass::Volume: {
-                auto& textureId = dynamic_cast<EditorVolume*>(node)->textureId;
-                textureSizeMap.emplace(node, textureId->size());
-                textureMap.emplace(node, DoubleBufferedTex{ textureId->getTexture(), TexType::Tex3D });
-                break;
-            }
-            case NodeClass::Keyboard: {
-                textureSizeMap.emplace(node, ImVec2{ 256, 3 });
-                textureMap.emplace(
-                    node, DoubleBufferedTex{ pipeline->createDynamicTexture(256, 3, setupKeyboardData), TexType::Tex2D });
-                break;
-            }
             default:
-                reportNotImplemented();
+                break;
         }
     }
+    for(auto& node : mNodes) {
+        if(node->getClass() == NodeClass::LastFrame) {
+            const auto ref = dynamic_cast<const EditorLastFrame&>(*node).lastFrame;
+            desc.nodes[nodeMap.at(node.get())].lastFrame = ref ? nodeMap.at(ref) : PipelineNode::invalidRef;
+        }
+    }
+    for(auto& link : mLinks) {
+        const auto u = findPin(link.startPinId);
+        const auto v = findPin(link.endPinId);
+        const auto slot = static_cast<uint32_t>(v - v->node->inputs.data());
+        desc.links.push_back(PipelineLink{ nodeMap.at(u->node), nodeMap.at(v->node), link.filter, link.wrapMode, slot });
+    }
+    desc.keyboard = setupKeyboardData;
+    return desc;
+}
 
-    return pipeline;
+void PipelineEditor::build(const ShaderToyContext& context) {
+    try {
+        mBuildStart = Clock::now();
+        mPendingBuild = ++mBuildCount;
+        // unchanged passes and their feedback buffers carry over, e.g. a simulation keeps running while grading is tweaked
+        mPendingInherited = mInheritState && context.getPipeline();
+        mPendingPipeline = buildPipeline(describePipeline(), mPendingInherited ? context.getPipeline() : nullptr);
+    } catch(const Error&) {
+        mPendingPipeline.reset();
+        Log(HelloImGui::LogLevel::Error, "Build failed");
+    }
 }
 
-void PipelineEditor::build(ShaderToyContext& context) {
+void PipelineEditor::pollPendingPipeline(ShaderToyContext& context) {
+    // a running export keeps the pipeline it started with, the new one is swapped in afterwards
+    if(!mPendingPipeline || context.isExporting())
+        return;
     try {
-        const auto start = Clock::now();
-        context.reset(buildPipeline());
+        if(!mPendingPipeline->poll())
+            return;
+        context.reset(std::move(mPendingPipeline), mPendingInherited && mKeepTime);
+        mRetiredTextures.erase(std::remove_if(mRetiredTextures.begin(), mRetiredTextures.end(),
+                                              [&](const auto& texture) { return texture.first < mPendingBuild; }),
+                               mRetiredTextures.end());
+        mInheritState = true;
         const auto duration =
-            static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()) * 1e-9;
+            static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - mBuildStart).count()) * 1e-9;
         Log(HelloImGui::LogLevel::Info, "Compiled in %.1f secs", duration);
     } catch(const Error&) {
+        mPendingPipeline.reset();
         Log(HelloImGui::LogLevel::Error, "Build failed");
     }
 }
 
+void PipelineEditor::retireTexture(std::unique_ptr<TextureObject> texture) {
+    if(texture)
+        mRetiredTextures.emplace_back(mBuildCount, std::move(texture));
+}
+
+void PipelineEditor::retireNode(EditorNode& node) {
+    switch(node.getClass()) {  // NOLINT(clang-diagnostic-switch-enum)
+        case NodeClass::Texture: {
+            auto& texture = dynamic_cast<EditorTexture&>(node);
+            retireTexture(std::move(texture.textureId));
+            if(texture.pendingImage.valid())
+                mAbandonedImages.push_back(std::move(texture.pendingImage));
+            break;
+        }
+        case NodeClass::CubeMap: {
+            auto& cubeMap = dynamic_cast<EditorCubeMap&>(node);
+            retireTexture(std::move(cubeMap.textureId));
+            if(cubeMap.pendingImage.valid())
+                mAbandonedImages.push_back(std::move(cubeMap.pendingImage));
+            break;
+        }
+        case NodeClass::Volume:
+            retireTexture(std::move(dynamic_cast<EditorVolume&>(node).textureId));
+            break;
+        default:
+            break;
+    }
+}
+
 void PipelineEditor::render(ShaderToyContext& context) {
     updateNodeType();
+    pollPendingSTTF();
+    pollPendingImport();
+    for(auto& node : mNodes)
+        mShouldBuildPipeline |= node->pollPendingAsset();
+    mAbandonedImages.erase(std::remove_if(mAbandonedImages.begin(), mAbandonedImages.end(),
+                                          [](const std::future<ImageStorage>& image) {
+                                              return image.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                          }),
+                           mAbandonedImages.end());
+    pollPendingPipeline(context);
+    mStatistics = context.getStatistics();
     if(!ImGui::Begin("Editor", nullptr)) {
         ImGui::End();
         return;
@@ -978,6 +925,26 @@ void PipelineEditor::render(ShaderToyContext& context) {
                 mShouldBuildPipeline = true;
             }
             ImGui::SameLine();
+            ImGui::Checkbox("Build on edit", &mBuildOnEdit);
+            ImGui::SameLine();
+            ImGui::Checkbox("Keep time", &mKeepTime);
+            if(isTextureCompressionSupported()) {
+                ImGui::SameLine();
+                ImGui::Checkbox("Compress textures", &mCompressTextures);
+            }
+            if(mPendingPipeline) {
+                ImGui::SameLine();
+                ImGui::TextUnformatted("Compiling...");
+            }
+            if(mPendingSTTF) {
+                ImGui::SameLine();
+                ImGui::ProgressBar(mPendingSTTF->getLoadProgress(), ImVec2{ 120.0f, 0.0f }, "Loading...");
+            }
+            if(mPendingImport) {
+                ImGui::SameLine();
+                ImGui::ProgressBar(mPendingImport->getProgress(), ImVec2{ 120.0f, 0.0f }, "Importing...");
+            }
+            ImGui::SameLine();
             if(ImGui::Button("Zoom to context")) {
                 mShouldZoomToContent = true;
             }
@@ -1041,7 +1008,10 @@ void PipelineEditor::render(ShaderToyContext& context) {
                 if(shader->isOpen &&
                    ImGui::BeginTabItem(shader->name.c_str(), &shader->isOpen,
                                        shader->requestFocus ? ImGuiTabItemFlags_SetSelected : ImGuiTabItemFlags_None)) {
-                    shader->editor.render(ImVec2(0, 0));
+                    if(shader->editor.render(ImVec2(0, 0))) {
+                        mEditedSinceBuild = true;
+                        mLastEdit = Clock::now();
+                    }
                     shader->requestFocus = false;
                     ImGui::EndTabItem();
                 }
@@ -1051,9 +1021,13 @@ void PipelineEditor::render(ShaderToyContext& context) {
     }
     ImGui::End();
 
+    // debounced, so that a build is only started after a pause in typing
+    if(mBuildOnEdit && mEditedSinceBuild && Clock::now() - mLastEdit > std::chrono::milliseconds{ 500 })
+        mShouldBuildPipeline = true;
     if(mShouldBuildPipeline) {
         build(context);
         mShouldBuildPipeline = false;
+        mEditedSinceBuild = false;
     }
 }
 
@@ -1077,62 +1051,141 @@ bool EditorShader::renderContent() {
     if(ImGui::Button(magic_enum::enum_name(type).data())) {
         type = static_cast<NodeType>((static_cast<uint32_t>(type) + 1) % 3);
     }
+    if(ImGui::Button(magic_enum::enum_name(format).data())) {
+        format = static_cast<Format>((static_cast<uint32_t>(format) + 1) % magic_enum::enum_count<Format>());
+    }
+    if(type == NodeType::CubeMap && ImGui::Button(fmt::format("{}x{}", faceSize, faceSize).c_str())) {
+        faceSize = faceSize >= 2048 ? 256 : faceSize * 2;
+    }
     return false;
 }
 std::unique_ptr<Node> EditorShader::toSTTF() const {
-    return std::make_unique<GLSLShader>(editor.getText(), type);
+    auto shader = std::make_unique<GLSLShader>(editor.getText(), type);
+    shader->format = format;
+    shader->faceSize = faceSize;
+    return shader;
 }
 void EditorShader::fromSTTF(Node& node) {
     const auto& shader = dynamic_cast<GLSLShader&>(node);
     type = shader.nodeType;
+    format = shader.format;
+    faceSize = shader.faceSize;
     editor.setText(shader.source);
 }
 
-struct ImageStorage final {
-    uint32_t width;
-    uint32_t height;
-    std::vector<uint32_t> data;
-};
-
-static ImageStorage loadImageFromFile(const char* path) {
-    HelloImGui::Log(HelloImGui::LogLevel::Info, "Loading image %s", path);
-    stbi_set_flip_vertically_on_load(true);
+static ImageStorage loadImageFromFile(const std::string& path) {
+    stbi_set_flip_vertically_on_load_thread(true);
     int width, height, channels;
-    const auto ptr = stbi_load(path, &width, &height, &channels, 4);
-    if(!ptr) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to load image %s: %s", path, stbi_failure_reason());
-        return { 0, 0, {} };
-    }
+    const auto ptr = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if(!ptr)
+        return { 0, 0, {}, std::nullopt, fmt::format("Failed to load image {}: {}", path, stbi_failure_reason()) };
     auto guard = scopeExit([ptr] { stbi_image_free(ptr); });
     const auto begin = reinterpret_cast<const uint32_t*>(ptr);
     const auto end = begin + static_cast<ptrdiff_t>(width) * height;
-    return { static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::vector<uint32_t>{ begin, end } };
+    return { static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::vector<uint32_t>{ begin, end }, std::nullopt, {} };
+}
+
+// faces is 6 for cube maps
+static ImageStorage compressIfEnabled(ImageStorage image, const uint32_t faces, const bool compress) {
+    if(compress && image.error.empty()) {
+        image.compressed = compressImage(image.width, image.height, faces, image.data.data());
+        image.data = {};
+    }
+    return image;
+}
+
+static std::future<ImageStorage> loadImageAsync(std::string path) {
+    HelloImGui::Log(HelloImGui::LogLevel::Info, "Loading image %s", path.c_str());
+    const auto compress = PipelineEditor::get().isTextureCompressionEnabled();
+    return std::async(std::launch::async,
+                      [path = std::move(path), compress] { return compressIfEnabled(loadImageFromFile(path), 1, compress); });
+}
+
+// the faces are decoded in parallel
+static std::future<ImageStorage> loadCubeMapAsync(std::vector<std::string> paths) {
+    for(auto& path : paths)
+        HelloImGui::Log(HelloImGui::LogLevel::Info, "Loading image %s", path.c_str());
+    const auto compress = PipelineEditor::get().isTextureCompressionEnabled();
+    return std::async(std::launch::async, [paths = std::move(paths), compress] {
+        std::vector<std::future<ImageStorage>> faces;
+        for(auto& path : paths)
+            faces.push_back(std::async(std::launch::async, [&path] { return loadImageFromFile(path); }));
+        ImageStorage cubeMap{ 0, 0, {}, std::nullopt, {} };
+        for(auto& future : faces) {
+            auto face = future.get();
+            if(!cubeMap.error.empty())
+                continue;
+            if(!face.error.empty()) {
+                cubeMap.error = std::move(face.error);
+                continue;
+            }
+            if(face.width != face.height || (cubeMap.width != 0 && cubeMap.width != face.width)) {
+                cubeMap.error = "The faces of cube map must be squares of the same size";
+                continue;
+            }
+            cubeMap.width = cubeMap.height = face.width;
+            cubeMap.data.insert(cubeMap.data.end(), face.data.cbegin(), face.data.cend());
+        }
+        return compressIfEnabled(std::move(cubeMap), 6, compress);
+    });
+}
+
+// for images that are already decoded, e.g. loaded from sttf files
+static std::future<ImageStorage> compressAsync(const uint32_t width, const uint32_t height, const uint32_t faces,
+                                               std::vector<uint32_t> data) {
+    return std::async(std::launch::async, [width, height, faces, data = std::move(data)]() mutable {
+        return compressIfEnabled(ImageStorage{ width, height, std::move(data), std::nullopt, {} }, faces, true);
+    });
 }
 
+static bool isReady(const std::future<ImageStorage>& image) {
+    return image.valid() && image.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// returns false and logs the error of a failed image
+static bool takeImage(std::future<ImageStorage>& pending, ImageStorage& image) {
+    image = pending.get();
+    if(image.error.empty())
+        return true;
+    HelloImGui::Log(HelloImGui::LogLevel::Error, "%s", image.error.c_str());
+    return false;
+}
+
+// bound until the picked image is decoded, so that the pipeline can be built meanwhile
+static constexpr uint32_t placeholderPixel = 0xff808080;
+
 bool EditorTexture::renderContent() {
     bool updateTex = false;
+    // replacing a pending image would wait for it
+    ImGui::BeginDisabled(pendingImage.valid());
     if(ImGui::Button(ICON_FA_FILE_IMAGE " Update")) {
-        [&] {
-            nfdchar_t* path;
-            if(NFD_OpenDialog("jpg,jpeg;bmp;png;tga;tiff", nullptr, &path) == NFD_OKAY) {
-                auto [width, height, img] = loadImageFromFile(path);
-                if(img.empty())
-                    return;
-                pixel = std::move(img);
-                textureId = loadTexture(width, height, pixel.data());
+        nfdchar_t* path;
+        if(NFD_OpenDialog("jpg,jpeg;bmp;png;tga;tiff", nullptr, &path) == NFD_OKAY) {
+            pendingImage = loadImageAsync(path);
+            if(!textureId) {
+                pixel = { placeholderPixel };
+                textureId = loadTexture(1, 1, pixel.data());
                 updateTex = true;
             }
-        }();
+        }
     }
-    if(textureId && ImGui::Button("Vertical Flip")) {
+    ImGui::EndDisabled();
+    if(pendingImage.valid()) {
+        ImGui::TextUnformatted("Loading...");
+    } else if(textureId && ImGui::Button("Vertical Flip")) {
         const auto width = static_cast<uint32_t>(textureId->size().x);
         const auto height = static_cast<uint32_t>(textureId->size().y);
-        for(uint32_t i = 0, j = height - 1; i < j; ++i, --j) {
-            for(uint32_t k = 0; k < width; ++k)
-                std::swap(pixel[i * width + k], pixel[j * width + k]);
-        }
-        textureId = loadTexture(width, height, pixel.data());
-        updateTex = true;
+        const auto compress = PipelineEditor::get().isTextureCompressionEnabled();
+        // the current image stays in use until the flipped one is ready
+        pendingImage = std::async(std::launch::async, [width, height, compress, data = pixel, source = compressed]() mutable {
+            if(source)
+                data = decompressImage(*source);
+            for(uint32_t i = 0, j = height - 1; i < j; ++i, --j) {
+                for(uint32_t k = 0; k < width; ++k)
+                    std::swap(data[i * width + k], data[j * width + k]);
+            }
+            return compressIfEnabled(ImageStorage{ width, height, std::move(data), std::nullopt, {} }, 1, compress);
+        });
     }
 
     if(textureId) {
@@ -1141,17 +1194,49 @@ bool EditorTexture::renderContent() {
     }
     return updateTex;
 }
+bool EditorTexture::pollPendingAsset() {
+    if(!isReady(pendingImage))
+        return false;
+    ImageStorage image;
+    if(!takeImage(pendingImage, image))
+        return false;
+    setImage(std::move(image));
+    return true;
+}
+void EditorTexture::setImage(ImageStorage image) {
+    PipelineEditor::get().retireTexture(std::move(textureId));
+    if(image.compressed) {
+        compressed = std::move(image.compressed);
+        pixel = {};
+        textureId = loadTexture(*compressed);
+    } else {
+        compressed.reset();
+        pixel = std::move(image.data);
+        textureId = loadTexture(image.width, image.height, pixel.data());
+    }
+}
 std::unique_ptr<Node> EditorTexture::toSTTF() const {
-    return std::make_unique<Texture>(static_cast<uint32_t>(textureId->size().x), static_cast<uint32_t>(textureId->size().y),
-                                     pixel);
+    auto texture = std::make_unique<Texture>(static_cast<uint32_t>(textureId->size().x),
+                                             static_cast<uint32_t>(textureId->size().y), pixel);
+    texture->compressed = compressed;
+    return texture;
 }
 void EditorTexture::fromSTTF(Node& node) {
-    const auto& texture = dynamic_cast<Texture&>(node);
-    pixel = texture.pixel;
-    textureId = loadTexture(texture.width, texture.height, pixel.data());
+    auto& texture = dynamic_cast<Texture&>(node);
+    if(texture.compressed) {
+        pixel = {};
+        compressed = std::move(texture.compressed);
+        textureId = loadTexture(*compressed);
+        return;
+    }
+    setImage(ImageStorage{ texture.width, texture.height, std::move(texture.pixel), std::nullopt, {} });
+    // the uncompressed image is used until the compressed one is ready
+    if(PipelineEditor::get().isTextureCompressionEnabled())
+        pendingImage = compressAsync(texture.width, texture.height, 1, pixel);
 }
 bool EditorCubeMap::renderContent() {
     bool updateTex = false;
+    ImGui::BeginDisabled(pendingImage.valid());
     if(ImGui::Button(ICON_FA_FILE_IMAGE " Update")) {
         [&] {
             nfdpathset_t pathSet;
@@ -1163,38 +1248,62 @@ bool EditorCubeMap::renderContent() {
                     return;
                 }
 
-                std::vector<uint32_t> tmp;
-                uint32_t size = 0;
-                for(int32_t idx = 0; idx < 6; ++idx) {
-                    auto [w, h, img] = loadImageFromFile(NFD_PathSet_GetPath(&pathSet, idx));
-                    if(img.empty())
-                        return;
-                    if(w != h)
-                        return;
-                    if(size == 0)
-                        size = w;
-                    else if(size != w)
-                        return;
-                    tmp.insert(tmp.end(), img.begin(), img.end());
+                std::vector<std::string> paths;
+                for(int32_t idx = 0; idx < 6; ++idx)
+                    paths.emplace_back(NFD_PathSet_GetPath(&pathSet, idx));
+                pendingImage = loadCubeMapAsync(std::move(paths));
+                if(!textureId) {
+                    pixel.assign(6, placeholderPixel);
+                    textureId = loadCubeMap(1, pixel.data());
+                    updateTex = true;
                 }
-                tmp.swap(pixel);
-                textureId = loadCubeMap(size, pixel.data());
-                updateTex = true;
             }
         }();
     }
+    ImGui::EndDisabled();
     // TODO: preview for cube map
-    ImGui::Text(textureId ? "Loaded" : "Unavailable");
+    ImGui::Text(pendingImage.valid() ? "Loading..." : textureId ? "Loaded" : "Unavailable");
 
     return updateTex;
 }
+bool EditorCubeMap::pollPendingAsset() {
+    if(!isReady(pendingImage))
+        return false;
+    ImageStorage image;
+    if(!takeImage(pendingImage, image))
+        return false;
+    setImage(std::move(image));
+    return true;
+}
+void EditorCubeMap::setImage(ImageStorage image) {
+    PipelineEditor::get().retireTexture(std::move(textureId));
+    if(image.compressed) {
+        compressed = std::move(image.compressed);
+        pixel = {};
+        textureId = loadCubeMap(*compressed);
+    } else {
+        compressed.reset();
+        pixel = std::move(image.data);
+        textureId = loadCubeMap(image.width, pixel.data());
+    }
+}
 std::unique_ptr<Node> EditorCubeMap::toSTTF() const {
-    return std::make_unique<CubeMap>(static_cast<uint32_t>(textureId->size().x), pixel);
+    auto texture = std::make_unique<CubeMap>(static_cast<uint32_t>(textureId->size().x), pixel);
+    texture->compressed = compressed;
+    return texture;
 }
 void EditorCubeMap::fromSTTF(Node& node) {
-    const auto& texture = dynamic_cast<CubeMap&>(node);
-    pixel = texture.pixel;
-    textureId = loadCubeMap(texture.size, pixel.data());
+    auto& texture = dynamic_cast<CubeMap&>(node);
+    if(texture.compressed) {
+        pixel = {};
+        compressed = std::move(texture.compressed);
+        textureId = loadCubeMap(*compressed);
+        return;
+    }
+    setImage(ImageStorage{ texture.size, texture.size, std::move(texture.pixel), std::nullopt, {} });
+    // the uncompressed image is used until the compressed one is ready
+    if(PipelineEditor::get().isTextureCompressionEnabled())
+        pendingImage = compressAsync(texture.size, texture.size, 6, pixel);
 }
 bool EditorVolume::renderContent() {
     return false;
@@ -1205,8 +1314,8 @@ std::unique_ptr<Node> EditorVolume::toSTTF() const {
     return std::make_unique<Volume>(static_cast<uint32_t>(textureId->size().x), static_cast<uint32_t>(channels), pixel);
 }
 void EditorVolume::fromSTTF(Node& node) {
-    const auto& texture = dynamic_cast<Volume&>(node);
-    pixel = texture.pixel;
+    auto& texture = dynamic_cast<Volume&>(node);
+    pixel = std::move(texture.pixel);
     textureId = loadVolume(texture.size, texture.channels, pixel.data());
 }
 
@@ -1263,77 +1372,103 @@ void EditorKeyboard::fromSTTF(Node&) {}
 void PipelineEditor::loadSTTF(const std::string& path) {
     try {
         HelloImGui::Log(HelloImGui::LogLevel::Info, "Loading sttf from %s", path.c_str());
-        ShaderToyTransmissionFormat sttf;
-        sttf.load(path);
-
-        std::vector<std::unique_ptr<EditorNode>> oldNodes;
+        mPendingSTTF.reset();  // cancels the previous load
+        mPendingImport.reset();
+        auto sttf = std::make_unique<ShaderToyTransmissionFormat>();
+        sttf->loadAsync(path);
+        mPendingSTTF = std::move(sttf);
+        mPendingSTTFPath = path;
+    } catch(const Error&) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to load sttf %s", path.c_str());
+    }
+}
+void PipelineEditor::pollPendingSTTF() {
+    if(!mPendingSTTF)
+        return;
+    try {
+        if(!mPendingSTTF->poll())
+            return;
+        applySTTF(*mPendingSTTF);
+    } catch(const Error&) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to load sttf %s", mPendingSTTFPath.c_str());
+    }
+    mPendingSTTF.reset();
+}
+// only uploads the decoded assets
+void PipelineEditor::applySTTF(ShaderToyTransmissionFormat& sttf) {
+    std::vector<std::unique_ptr<EditorNode>> oldNodes;
+    oldNodes.swap(mNodes);
+    std::vector<EditorLink> oldLinks;
+    oldLinks.swap(mLinks);
+    std::vector<std::pair<std::string, std::string>> oldMetadata;
+    oldMetadata.swap(mMetadata);
+    auto guard = scopeFail([&] {
         oldNodes.swap(mNodes);
-        std::vector<EditorLink> oldLinks;
         oldLinks.swap(mLinks);
-        std::vector<std::pair<std::string, std::string>> oldMetadata;
         oldMetadata.swap(mMetadata);
-        auto guard = scopeFail([&] {
-            oldNodes.swap(mNodes);
-            oldLinks.swap(mLinks);
-            oldMetadata.swap(mMetadata);
-        });
+    });
 
-        for(auto [k, v] : sttf.metadata) {
-            mMetadata.emplace_back(k, v);
-        }
+    for(auto [k, v] : sttf.metadata) {
+        mMetadata.emplace_back(k, v);
+    }
 
-        std::unordered_map<Node*, EditorNode*> nodeMap;
-        for(auto& node : sttf.nodes) {
-            EditorNode* newNode = nullptr;
-            switch(node->getNodeClass()) {  // NOLINT(clang-diagnostic-switch-enum)
-                case NodeClass::RenderOutput: {
-                    newNode = &spawnRenderOutput();
-                } break;
-                case NodeClass::GLSLShader: {
-                    newNode = &spawnShader(node->getNodeType());
-                } break;
-                case NodeClass::Texture: {
-                    newNode = &spawnTexture();
-                } break;
-                case NodeClass::CubeMap: {
-                    newNode = &spawnCubeMap();
-                } break;
-                case NodeClass::LastFrame: {
-                    newNode = &spawnLastFrame();
-                } break;
-                case NodeClass::Keyboard: {
-                    newNode = &spawnKeyboard();
-                } break;
-                default: {
-                    reportNotImplemented();
-                }
+    std::unordered_map<Node*, EditorNode*> nodeMap;
+    for(auto& node : sttf.nodes) {
+        EditorNode* newNode = nullptr;
+        switch(node->getNodeClass()) {  // NOLINT(clang-diagnostic-switch-enum)
+            case NodeClass::RenderOutput: {
+                newNode = &spawnRenderOutput();
+            } break;
+            case NodeClass::GLSLShader: {
+                newNode = &spawnShader(node->getNodeType());
+            } break;
+            case NodeClass::Texture: {
+                newNode = &spawnTexture();
+            } break;
+            case NodeClass::CubeMap: {
+                newNode = &spawnCubeMap();
+            } break;
+            case NodeClass::Volume: {
+                newNode = &spawnVolume();
+            } break;
+            case NodeClass::LastFrame: {
+                newNode = &spawnLastFrame();
+            } break;
+            case NodeClass::Keyboard: {
+                newNode = &spawnKeyboard();
+            } break;
+            default: {
+                reportNotImplemented();
             }
-
-            newNode->fromSTTF(*node);
-            nodeMap.emplace(node.get(), newNode);
         }
 
-        // fix references of LastFrame
-        for(auto& node : sttf.nodes) {
-            if(node->getNodeClass() == NodeClass::LastFrame) {
-                auto editorNode = nodeMap.at(node.get());
-                dynamic_cast<EditorLastFrame*>(editorNode)->lastFrame = nodeMap.at(dynamic_cast<LastFrame*>(node.get())->refNode);
-            }
-        }
+        if(!node->name.empty() && isUniqueName(node->name, newNode))
+            newNode->name = node->name;
+        newNode->fromSTTF(*node);
+        nodeMap.emplace(node.get(), newNode);
+    }
 
-        for(auto& [start, end, filter, wrapMode, slot] : sttf.links) {
-            auto startNode = nodeMap.at(start);
-            auto endNode = nodeMap.at(end);
-            mLinks.emplace_back(nextId(), startNode->outputs.front().id, endNode->inputs[slot].id, filter, wrapMode);
+    // fix references of LastFrame
+    for(auto& node : sttf.nodes) {
+        if(node->getNodeClass() == NodeClass::LastFrame) {
+            auto editorNode = nodeMap.at(node.get());
+            dynamic_cast<EditorLastFrame*>(editorNode)->lastFrame = nodeMap.at(dynamic_cast<LastFrame*>(node.get())->refNode);
         }
+    }
 
-        HelloImGui::Log(HelloImGui::LogLevel::Info, "Success!");
-
-        mShouldResetLayout = true;
-        mShouldBuildPipeline = true;
-    } catch(const Error&) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to load sttf %s", path.c_str());
+    for(auto& [start, end, filter, wrapMode, slot] : sttf.links) {
+        auto startNode = nodeMap.at(start);
+        auto endNode = nodeMap.at(end);
+        mLinks.emplace_back(nextId(), startNode->outputs.front().id, endNode->inputs[slot].id, filter, wrapMode);
     }
+
+    HelloImGui::Log(HelloImGui::LogLevel::Info, "Success!");
+
+    for(auto& node : oldNodes)
+        retireNode(*node);
+    mShouldResetLayout = true;
+    mShouldBuildPipeline = true;
+    mInheritState = false;
 }
 void PipelineEditor::saveSTTF(const std::string& path) {
     try {
@@ -1360,365 +1495,29 @@ void PipelineEditor::saveSTTF(const std::string& path) {
         HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to save sttf %s", path.c_str());
     }
 }
-void PipelineEditor::loadFromShaderToy(const std::string& path) {
-    std::vector<std::unique_ptr<EditorNode>> oldNodes;
-    oldNodes.swap(mNodes);
-    std::vector<EditorLink> oldLinks;
-    oldLinks.swap(mLinks);
-    std::vector<std::pair<std::string, std::string>> oldMetadata;
-    oldMetadata.swap(mMetadata);
-    auto guard = scopeFail([&] {
-        oldNodes.swap(mNodes);
-        oldLinks.swap(mLinks);
-        oldMetadata.swap(mMetadata);
-    });
-
-    std::string_view shaderId = path;
-    if(const auto pos = shaderId.find_last_of('/'); pos != std::string_view::npos)
-        shaderId = shaderId.substr(pos + 1);
-    const auto url = fmt::format("https://www.shadertoy.com/view/{}", shaderId);
-    HelloImGui::Log(HelloImGui::LogLevel::Info, "Loading from %s", url.c_str());
-    httplib::SSLClient client{ "www.shadertoy.com" };
-    httplib::Headers headers;
-    headers.emplace("referer", url);
-    auto res = client.Post("/shadertoy", headers, std::string(R"(s={"shaders":[")") + shaderId.data() + "\"]}&nt=1&nl=1&np=1",
-                           "application/x-www-form-urlencoded");
-    int status = res.value().status;
-    if(status != 200) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Invalid response from shadertoy.com (Status code = %d).", status);
-        throw Error{};
-    }
-    auto json = nlohmann::json::parse(res->body);
-    if(!json.is_array()) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Invalid response from shadertoy.com");
-        throw Error{};
-    }
-    auto metadata = json[0].at("info");
-
-    mMetadata.emplace_back("Name", metadata.at("name").get<std::string>());
-    mMetadata.emplace_back("Author", metadata.at("username").get<std::string>());
-    mMetadata.emplace_back("Description", metadata.at("description").get<std::string>());
-    mMetadata.emplace_back("ShaderToyURL", url);
-
-    auto renderPasses = json[0].at("renderpass");
-    // BA BB BC BD CA IE
-    auto getOrder = [](const std::string& name) { return std::toupper(name.front()) * 1000 + std::toupper(name.back()); };
-
-    std::unordered_map<std::string, EditorShader*> newShaderNodes;
-
-    auto& sinkNode = spawnRenderOutput();
-    auto addLink = [&](EditorNode* src, EditorNode* dst, uint32_t channel, nlohmann::json* ref) {
-        auto filter = Filter::Linear;
-        auto wrapMode = Wrap::Repeat;
-        if(ref) {
-            auto sampler = ref->at("sampler");
-            const auto filterName = sampler.at("filter").get<std::string>();
-            const auto wrapName = sampler.at("wrap").get<std::string>();
-            if(filterName == "linear") {
-                filter = Filter::Linear;
-            } else if(filterName == "nearest") {
-                filter = Filter::Nearest;
-            } else if(filterName == "mipmap") {
-                filter = Filter::Mipmap;
-            } else {
-                reportNotImplemented();
-            }
-
-            if(wrapName == "clamp") {
-                wrapMode = Wrap::Clamp;
-            } else if(wrapName == "repeat") {
-                wrapMode = Wrap::Repeat;
-            } else {
-                reportNotImplemented();
-            }
-        }
-        mLinks.emplace_back(nextId(), src->outputs.front().id, dst->inputs[channel].id, filter, wrapMode);
-    };
-    EditorNode* keyboard = nullptr;
-    auto getKeyboard = [&] {
-        if(!keyboard)
-            keyboard = &spawnKeyboard();
-        return keyboard;
-    };
-    std::unordered_map<std::string, EditorTexture*> textureCache;
-    auto getTexture = [&](nlohmann::json& tex) -> EditorTexture* {
-        const auto id = tex.at("id").get<std::string>();
-        if(const auto iter = textureCache.find(id); iter != textureCache.cend())
-            return iter->second;
-        auto& texture = spawnTexture();
-        const auto texPath = tex.at("filepath").get<std::string>();
-        HelloImGui::Log(HelloImGui::LogLevel::Info, "Downloading texture %s", texPath.c_str());
-        auto img = client.Get(texPath, headers);
-
-        stbi_set_flip_vertically_on_load(tex.at("sampler").at("vflip").get<std::string>() == "true");
-        int width, height, channels;
-        const auto ptr = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(img->body.data()),
-                                               static_cast<int>(img->body.size()), &width, &height, &channels, 4);
-        if(!ptr) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Failed to load texture %s: %s", texPath.c_str(), stbi_failure_reason());
-            throw Error{};
-        }
-        const auto imgGuard = scopeExit([ptr] { stbi_image_free(ptr); });
-        const auto begin = reinterpret_cast<const uint32_t*>(ptr);
-        const auto end = begin + static_cast<ptrdiff_t>(width) * height;
-        texture.pixel = std::vector<uint32_t>{ begin, end };
-        texture.textureId = loadTexture(static_cast<uint32_t>(width), static_cast<uint32_t>(height), texture.pixel.data());
-
-        textureCache.emplace(id, &texture);
-        return &texture;
-    };
-    std::unordered_map<std::string, EditorCubeMap*> cubeMapCache;
-    auto getCubeMap = [&](nlohmann::json& tex) -> EditorCubeMap* {
-        const auto id = tex.at("id").get<std::string>();
-        if(const auto iter = cubeMapCache.find(id); iter != cubeMapCache.cend())
-            return iter->second;
-        auto& texture = spawnCubeMap();
-        const auto texPath = tex.at("filepath").get<std::string>();
-        std::string base, ext;
-        if(const auto pos = texPath.find_last_of('.'); pos != std::string::npos) {
-            base = texPath.substr(0, pos);
-            ext = texPath.substr(pos);
-        } else {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Failed to parse cube map %s", texPath.c_str());
-            throw Error{};
-        }
-
-        constexpr const char* suffixes[] = { "", "_1", "_2", "_3", "_4", "_5" };
-        int32_t size = 0;
-        for(const auto suffix : suffixes) {
-            auto facePath = base;
-            facePath += suffix;
-            facePath += ext;
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Downloading texture %s", facePath.c_str());
-            auto img = client.Get(facePath, headers);
-
-            stbi_set_flip_vertically_on_load(tex.at("sampler").at("vflip").get<std::string>() == "true");
-            int width, height, channels;
-            const auto ptr = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(img->body.data()),
-                                                   static_cast<int>(img->body.size()), &width, &height, &channels, 4);
-            if(!ptr) {
-                HelloImGui::Log(HelloImGui::LogLevel::Info, "Failed to load texture %s: %s", facePath.c_str(),
-                                stbi_failure_reason());
-                throw Error{};
-            }
-            const auto imgGuard = scopeExit([ptr] { stbi_image_free(ptr); });
-            const auto begin = reinterpret_cast<const uint32_t*>(ptr);
-            const auto end = begin + static_cast<ptrdiff_t>(width) * height;
-            texture.pixel.insert(texture.pixel.end(), begin, end);
-            if(width != height) {
-                throw Error{};
-            }
-            if(size == 0)
-                size = width;
-            else if(size != width) {
-                throw Error{};
-            }
-        }
-
-        texture.textureId = loadCubeMap(static_cast<uint32_t>(size), texture.pixel.data());
-        cubeMapCache.emplace(id, &texture);
-        return &texture;
-    };
-    std::unordered_map<std::string, EditorVolume*> volumeCache;
-    auto getVolume = [&](nlohmann::json& tex) -> EditorVolume* {
-        const auto id = tex.at("id").get<std::string>();
-        if(const auto iter = volumeCache.find(id); iter != volumeCache.cend())
-            return iter->second;
-        auto& texture = spawnVolume();
-        const auto texPath = tex.at("filepath").get<std::string>();
-        HelloImGui::Log(HelloImGui::LogLevel::Info, "Downloading volume %s", texPath.c_str());
-        auto img = client.Get(texPath, headers);
-        if(img->body.empty()) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Failed to load texture %s: %s", texPath.c_str(), stbi_failure_reason());
-            throw Error{};
-        }
-        if(img->body.size() < 20ULL) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Invalid volume format %s: %zu", texPath.c_str(), img->body.size());
-            throw Error{};
-        }
-        auto begin = reinterpret_cast<const uint32_t*>(img->body.data());
-        uint32_t x = *++begin;
-        uint32_t y = *++begin;
-        uint32_t z = *++begin;
-        if(x != y || y != z) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Unsupported volume size %s: (%u, %u, %u)", texPath.c_str(), x, y, z);
-            throw Error{};
-        }
-        uint32_t channels_layout_format = *++begin;
-        struct Metadata final {
-            uint8_t channels;
-            uint8_t layout;
-            uint16_t format;
-        } metadata;
-        static_assert(sizeof(metadata) == sizeof(uint32_t));
-        memcpy(&metadata, &channels_layout_format, sizeof(Metadata));
-
-        if(metadata.channels != 1 && metadata.channels != 4) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Unsupported volume channels %s: %u", texPath.c_str(), metadata.channels);
-            throw Error{};
-        }
-
-        if(metadata.layout != 0) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Unsupported volume layout %s: %u", texPath.c_str(), metadata.layout);
-            throw Error{};
-        }
-
-        if(metadata.format != 0) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Unsupported volume format %s: %u", texPath.c_str(), metadata.format);
-            throw Error{};
-        }
-
-        const uint32_t size = x;
-        const uint32_t channels = metadata.channels;
-        const size_t points = static_cast<size_t>(size) * size * size * channels;
-        if(img->body.size() != 20 + points) {
-            HelloImGui::Log(HelloImGui::LogLevel::Info, "Invalid volume format %s: %zu", texPath.c_str(), img->body.size());
-            throw Error{};
-        }
-        const auto start = img->body.data() + 20;
-        const auto end = start + points;
-        texture.pixel = std::vector<uint8_t>{ start, end };
-        texture.textureId = loadVolume(size, channels, texture.pixel.data());
-
-        volumeCache.emplace(id, &texture);
-        return &texture;
-    };
-    std::unordered_set<std::string> passIds;
-    // Look at any index.html at EffectPass.prototype.NewTexture if(assetID_to_cubemapBuferId)
-    const auto isDynamicCubeMap = [&](nlohmann::json& tex) {
-        const auto id = tex.at("id").get<std::string>();
-        return id == "4dX3Rr";
-    };
-    std::string common;
-    for(auto& pass : renderPasses) {
-        if(pass.at("name").get<std::string>().empty()) {
-            pass.at("name") = generateUniqueName(pass.at("type").get<std::string>());
-        }
-
-        if(pass.at("outputs").empty()) {
-            pass.at("outputs").push_back(nlohmann::json::object({ { "id", "tmp" + std::to_string(nextId()) } }));
-        }
-
-        passIds.insert(pass.at("outputs")[0].at("id").get<std::string>());
-    }
-    for(auto& pass : renderPasses) {
-        const auto type = pass.at("type").get<std::string>();
-        const auto code = pass.at("code").get<std::string>();
-        const auto name = pass.at("name").get<std::string>();
-        if(type == "common") {
-            common = code + '\n';
-        } else if(type == "image" || type == "buffer" || type == "cubemap") {
-            const auto output = pass.at("outputs")[0].at("id").get<std::string>();
-            auto nodeType = type == "cubemap" ? NodeType::CubeMap : NodeType::Image;
-
-            auto& node = spawnShader(nodeType);
-            node.editor.setText(code);
-            node.name = name;
-            newShaderNodes.emplace(output, &node);
-
-            for(auto& input : pass.at("inputs")) {
-                auto inputType = input.at("type").get<std::string>();
-                if(inputType == "buffer") {
-                    continue;
-                }
-                auto channel = input.at("channel").get<uint32_t>();
-                if(inputType == "keyboard") {
-                    addLink(getKeyboard(), &node, channel, &input);
-                } else if(inputType == "texture") {
-                    addLink(getTexture(input), &node, channel, &input);
-                } else if(inputType == "cubemap") {
-                    if(!isDynamicCubeMap(input))
-                        addLink(getCubeMap(input), &node, channel, &input);
-                } else if(inputType == "volume") {
-                    addLink(getVolume(input), &node, channel, &input);
-                } else {
-                    Log(HelloImGui::LogLevel::Error, "Unsupported input type %s", inputType.c_str());
-                }
-            }
-
-            if(type == "image") {
-                addLink(&node, &sinkNode, 0, nullptr);
-            }
-        } else {
-            Log(HelloImGui::LogLevel::Error, "Unsupported pass type %s", type.c_str());
-        }
-    }
-
-    if(!common.empty()) {
-        for(auto& [name, shader] : newShaderNodes) {
-            shader->editor.setText(common + shader->editor.getText());
-        }
-    }
-
-    std::unordered_map<EditorShader*, EditorLastFrame*> lastFrames;
-    auto getLastFrame = [&](EditorShader* src) {
-        if(const auto iter = lastFrames.find(src); iter != lastFrames.cend()) {
-            return iter->second;
-        }
-        auto& lastFrame = spawnLastFrame();
-        lastFrame.lastFrame = src;
-        lastFrames.emplace(src, &lastFrame);
-        return &lastFrame;
-    };
-    for(auto& pass : renderPasses) {
-        const auto type = pass.at("type").get<std::string>();
-        if(type == "common") {
-            continue;
-        }
-        if(type == "image" || type == "buffer" || type == "cubemap") {
-            const auto name = pass.at("name").get<std::string>();
-            const auto idxDst = getOrder(name);
-            const auto node = newShaderNodes.at(pass.at("outputs")[0].at("id").get<std::string>());
-
-            for(auto& input : pass.at("inputs")) {
-                auto inputType = input.at("type").get<std::string>();
-                bool dynamicCubeMap = inputType == "cubemap" && isDynamicCubeMap(input);
-                if(inputType != "buffer" && !dynamicCubeMap) {
-                    continue;
-                }
-
-                auto channel = input.at("channel").get<uint32_t>();
-                auto inputId = input.at("id").get<std::string>();
-
-                // There is only one dynamic cube map in Shadertoy, so we can safely use the first one
-                if(dynamicCubeMap) {
-                    for(auto& innerPass : renderPasses) {
-                        if(innerPass.at("type").get<std::string>() != "cubemap") {
-                            continue;
-                        }
-
-                        if(innerPass.at("outputs").empty())
-                            continue;
-
-                        inputId = innerPass.at("outputs")[0].at("id").get<std::string>();
-                        channel = innerPass.at("outputs")[0].at("channel").get<uint32_t>();
-                        break;
-                    }
-                }
-
-                if(!newShaderNodes.count(inputId)) {
-                    // Shadertoy doesn't fail when an input is missing, so we create a default dummy node
-                    auto& inputNode = spawnShader(inputType != "cubemap" ? NodeType::Image : NodeType::CubeMap);
-                    inputNode.editor.setText(common + (inputType == "cubemap" ? initialCubeMap : initialBuffer));
-                    inputNode.name = inputId;
-                    newShaderNodes.emplace(inputId, &inputNode);
-                }
-
-                auto src = newShaderNodes.at(inputId);
-                const auto idxSrc = getOrder(src->name);
-                if(idxSrc < idxDst) {
-                    addLink(src, node, channel, &input);
-                } else {
-                    addLink(getLastFrame(src), node, channel, &input);
-                }
-            }
-        } else {
-            Log(HelloImGui::LogLevel::Error, "Unsupported pass type %s", type.c_str());
-        }
+void PipelineEditor::loadFromShaderToy(const std::string& path, const bool offline) {
+    mPendingSTTF.reset();
+    mPendingImport.reset();  // cancels the previous import
+    mPendingImport = std::make_unique<ShaderToyImporter>(path, offline);
+}
+void PipelineEditor::pollPendingImport() {
+    if(!mPendingImport || !mPendingImport->poll())
+        return;
+    try {
+        if(auto sttf = mPendingImport->takeResult())
+            applySTTF(*sttf);
+        else if(mPendingImport->isCancelled())
+            HelloImGui::Log(HelloImGui::LogLevel::Info, "Import cancelled");
+        else
+            HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to import %s", mPendingImport->getUrl().c_str());
+    } catch(const Error&) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to import %s", mPendingImport->getUrl().c_str());
     }
-
-    mShouldResetLayout = true;
-    mShouldBuildPipeline = true;
+    mPendingImport.reset();
+}
+void PipelineEditor::cancelImport() {
+    if(mPendingImport)
+        mPendingImport->cancel();
 }
 
 std::string PipelineEditor::getShaderName() const {
@@ -17,8 +17,12 @@
 #include "shadertoy/Config.hpp"
 #include "shadertoy/NodeEditor/Builders.hpp"
 #include "shadertoy/NodeEditor/Widgets.hpp"
+#include "shadertoy/PipelineBuilder.hpp"
 #include "shadertoy/STTF.hpp"
+#include "shadertoy/ShaderToyImporter.hpp"
 #include "shadertoy/ShaderToyContext.hpp"
+#include <future>
+#include <optional>
 
 #include "shadertoy/SuppressWarningPush.hpp"
 
@@ -38,7 +42,7 @@ public:
 
     [[nodiscard]] std::string getText() const;
     void setText(const std::string& str);
-    void render(ImVec2 size);
+    bool render(ImVec2 size);  // returns true if the text was edited
 };
 
 namespace ed = ax::NodeEditor;
@@ -78,6 +82,10 @@ struct EditorNode {
     virtual bool renderContent() {
         return false;
     }
+    // uploads the assets decoded in the background, returns true if the pipeline should be rebuilt
+    virtual bool pollPendingAsset() {
+        return false;
+    }
 
     [[nodiscard]] virtual std::unique_ptr<Node> toSTTF() const = 0;
     virtual void fromSTTF(Node& node) = 0;
@@ -94,6 +102,8 @@ struct EditorRenderOutput final : EditorNode {
 
 struct EditorShader final : EditorNode {
     ShaderToyEditor editor;
+    Format format = Format::Auto;  // shaders loaded from files keep theirs
+    uint32_t faceSize = GLSLShader::defaultFaceSize;
     bool isOpen = false;
     bool requestFocus = false;
 
@@ -121,12 +131,26 @@ struct EditorLastFrame final : EditorNode {
     }
 };
 
+// prepared on a worker thread: decoded from files and block-compressed if enabled in the editor
+struct ImageStorage final {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint32_t> data;
+    std::optional<CompressedImage> compressed;  // replaces data if present
+    std::string error;
+};
+
 struct EditorTexture final : EditorNode {
     std::vector<uint32_t> pixel;
+    std::optional<CompressedImage> compressed;  // replaces pixel if present
     std::unique_ptr<TextureObject> textureId;
+    std::future<ImageStorage> pendingImage;
 
     EditorTexture(const uint32_t idVal, std::string nameVal) : EditorNode(idVal, std::move(nameVal)) {}
+    // only uploads, the image is prepared in the background
+    void setImage(ImageStorage image);
     bool renderContent() override;
+    bool pollPendingAsset() override;
     [[nodiscard]] std::unique_ptr<Node> toSTTF() const override;
     void fromSTTF(Node& node) override;
 
@@ -137,10 +161,15 @@ struct EditorTexture final : EditorNode {
 
 struct EditorCubeMap final : EditorNode {
     std::vector<uint32_t> pixel;
+    std::optional<CompressedImage> compressed;  // replaces pixel if present
     std::unique_ptr<TextureObject> textureId;
+    std::future<ImageStorage> pendingImage;  // the faces are decoded in parallel
 
     EditorCubeMap(const uint32_t idVal, std::string nameVal) : EditorNode(idVal, std::move(nameVal)) {}
+    // only uploads, the image is prepared in the background
+    void setImage(ImageStorage image);
     bool renderContent() override;
+    bool pollPendingAsset() override;
     [[nodiscard]] std::unique_ptr<Node> toSTTF() const override;
     void fromSTTF(Node& node) override;
 
@@ -200,9 +229,31 @@ class PipelineEditor final {
     ed::LinkId mContextLinkId;
     std::vector<const char*> mShaderNodeNames;
     std::vector<EditorNode*> mShaderNodes;
+    std::vector<PassStatistics> mStatistics;
     bool mShouldZoomToContent = false;
     bool mShouldResetLayout = false;
     bool mShouldBuildPipeline = false;
+    bool mBuildOnEdit = false;
+    bool mEditedSinceBuild = false;
+    Clock::time_point mLastEdit;
+    bool mKeepTime = true;
+    bool mCompressTextures = false;  // applies to textures loaded afterwards
+    bool mInheritState = false;  // the next build continues the running pipeline
+    // compiled in the background, replaces the running pipeline once linked
+    std::unique_ptr<Pipeline> mPendingPipeline;
+    bool mPendingInherited = false;
+    uint64_t mBuildCount = 0;
+    uint64_t mPendingBuild = 0;
+    // replaced textures with the number of builds started before, the running pipeline may still bind them
+    std::vector<std::pair<uint64_t, std::unique_ptr<TextureObject>>> mRetiredTextures;
+    // images still loading for removed nodes, dropped once ready because destroying a pending future blocks
+    std::vector<std::future<ImageStorage>> mAbandonedImages;
+    Clock::time_point mBuildStart;
+    // assets are decoded in the background, the graph is replaced once all of them are ready
+    std::unique_ptr<ShaderToyTransmissionFormat> mPendingSTTF;
+    std::string mPendingSTTFPath;
+    // downloaded in the background, the graph is replaced once the import completed
+    std::unique_ptr<ShaderToyImporter> mPendingImport;
     bool mOpenMetadataEditor = false;
     bool mMetadataEditorRequestFocus = false;
 
@@ -225,19 +276,35 @@ class PipelineEditor final {
     EditorShader& spawnShader(NodeType type);
     EditorKeyboard& spawnKeyboard();
     void updateNodeType();
-    std::unique_ptr<Pipeline> buildPipeline();
+    [[nodiscard]] PipelineDesc describePipeline() const;
+    void pollPendingPipeline(ShaderToyContext& context);
+    void pollPendingSTTF();
+    void pollPendingImport();
+    void applySTTF(ShaderToyTransmissionFormat& sttf);
+    void retireNode(EditorNode& node);
 
     friend struct EditorLastFrame;
 
 public:
     PipelineEditor();
     ~PipelineEditor();
-    void build(ShaderToyContext& context);
+    void build(const ShaderToyContext& context);
     void render(ShaderToyContext& context);
     void resetPipeline();
     void loadSTTF(const std::string& path);
     void saveSTTF(const std::string& path);
-    void loadFromShaderToy(const std::string& path);
+    // offline, the shader and its media are only read from the media cache
+    void loadFromShaderToy(const std::string& path, bool offline = false);
+    // null unless an import is in progress
+    [[nodiscard]] const ShaderToyImporter* getPendingImport() const noexcept {
+        return mPendingImport.get();
+    }
+    void cancelImport();
+    [[nodiscard]] bool isTextureCompressionEnabled() const noexcept {
+        return mCompressTextures;
+    }
+    // keeps the texture alive until a pipeline built after this call replaced the running one
+    void retireTexture(std::unique_ptr<TextureObject> texture);
     [[nodiscard]] std::string getShaderName() const;
 
     static PipelineEditor& get();
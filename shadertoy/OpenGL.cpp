@@ -13,9 +13,14 @@
 */
 
 #include "shadertoy/Backend.hpp"
+#include "shadertoy/DiskCache.hpp"
 #include "shadertoy/Support.hpp"
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
 
 #include "shadertoy/SuppressWarningPush.hpp"
 
@@ -28,28 +33,59 @@ SHADERTOY_NAMESPACE_BEGIN
 
 static const char* const shaderVersionDirective = "#version 410 core\n";
 static const char* const shaderCubeMapDef = "#define INTERFACE_SHADERTOY_CUBE_MAP\n";
-static const char* const shaderVertexSrc = R"(
-layout (location = 0) in vec2 pos;
-layout (location = 1) in vec2 texCoord;
-#ifdef INTERFACE_SHADERTOY_CUBE_MAP
-layout (location = 2) in vec3 point;
-#endif
+// shared by both stages, see PassUniformBlock
+static const char* const shaderPassBlock = R"(
+layout (std140) uniform ShaderToyPass {
+    vec3      iResolution;               // viewport resolution (in pixels)
+    vec3      iChannelResolution[4];
+};
+)";
 
+// A single triangle covering the viewport, generated from gl_VertexID without any vertex buffer.
+// Cube maps draw six instances, one per face; shadertoy_face_* are prepended by getCubeMapFaceBasis.
+static const char* const shaderVertexSrc = R"(
 layout (location = 0) out vec2 f_fragCoord;
 #ifdef INTERFACE_SHADERTOY_CUBE_MAP
 layout (location = 1) out vec3 f_point;
+layout (location = 2) flat out int f_face;
 #endif
 
 void main() {
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0f - 1.0f;
     gl_Position = vec4(pos, 0.0f, 1.0f);
-    f_fragCoord = texCoord;
+    f_fragCoord = (pos * 0.5f + 0.5f) * iResolution.xy;
 #ifdef INTERFACE_SHADERTOY_CUBE_MAP
-    f_point = point;
+    f_point = shadertoy_face_center[gl_InstanceID] + pos.x * shadertoy_face_right[gl_InstanceID] +
+        pos.y * shadertoy_face_up[gl_InstanceID];
+    f_face = gl_InstanceID;
 #endif
 }
 
 )";
 
+// Routes each instance of a cube map pass to its face of the layered frame buffer
+static const char* const shaderGeometrySrc = R"(
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+layout (location = 0) in vec2 g_fragCoord[];
+layout (location = 1) in vec3 g_point[];
+layout (location = 2) flat in int g_face[];
+layout (location = 0) out vec2 f_fragCoord;
+layout (location = 1) out vec3 f_point;
+
+void main() {
+    for(int idx = 0; idx < 3; ++idx) {
+        gl_Position = gl_in[idx].gl_Position;
+        gl_Layer = g_face[0];
+        f_fragCoord = g_fragCoord[idx];
+        f_point = g_point[idx];
+        EmitVertex();
+    }
+    EndPrimitive();
+}
+)";
+
 static const char* const shaderPixelHeader = R"(
 layout (location = 0) in vec2 f_fragCoord;
 #ifdef INTERFACE_SHADERTOY_CUBE_MAP
@@ -58,14 +94,14 @@ layout (location = 1) in vec3 f_point;
 
 layout (location = 0) out vec4 out_frag_color;
 
-uniform vec3      iResolution;           // viewport resolution (in pixels)
-uniform float     iTime;                 // shader playback time (in seconds)
-uniform float     iTimeDelta;            // render time (in seconds)
-uniform float     iFrameRate;            // shader frame rate
-uniform int       iFrame;                // shader playback frame
-uniform vec4      iMouse;                // mouse pixel coords. xy: current (if MLB down), zw: click
-uniform vec4      iDate;                 // Year, month, day, time in seconds in .xyzw
-uniform vec3 iChannelResolution[4];
+layout (std140) uniform ShaderToyGlobal {
+    vec4      iMouse;                    // mouse pixel coords. xy: current (if MLB down), zw: click
+    vec4      iDate;                     // Year, month, day, time in seconds in .xyzw
+    float     iTime;                     // shader playback time (in seconds)
+    float     iTimeDelta;                // render time (in seconds)
+    float     iFrameRate;                // shader frame rate
+    int       iFrame;                    // shader playback frame
+};
 
 #define char char_
 )";
@@ -89,10 +125,23 @@ void main() {
 }
 )";
 
-struct Vertex final {
-    ImVec2 pos;
-    ImVec2 coord;
+// std140 mirrors of the uniform blocks in shaderPixelHeader
+static constexpr GLuint globalUniformBinding = 0;
+static constexpr GLuint passUniformBinding = 1;
+struct GlobalUniformBlock final {
+    float mouse[4];
+    float date[4];
+    float time;
+    float timeDelta;
+    float frameRate;
+    int32_t frame;
+};
+static_assert(sizeof(GlobalUniformBlock) == 48);
+struct PassUniformBlock final {
+    float resolution[4];
+    float channelResolution[4][4];
 };
+static_assert(sizeof(PassUniformBlock) == 80);
 
 using Vec3 = std::array<float, 3>;
 
@@ -110,11 +159,44 @@ constexpr uint32_t cubeMapVertexIndex[6][4] = {
     { 4, 6, 2, 0 }   // -Z (front face)
 };
 
-struct VertexCubeMap final {  // NOLINT(cppcoreguidelines-pro-type-member-init)
-    ImVec2 pos;
-    ImVec2 coord;
-    Vec3 point;
-};
+// Maps the viewport of a cube map face onto the face: point = center + x * right + y * up for x, y in [-1, 1]
+static std::string getCubeMapFaceBasis() {
+    std::string right = "const vec3 shadertoy_face_right[6] = vec3[6](";
+    std::string up = "const vec3 shadertoy_face_up[6] = vec3[6](";
+    std::string center = "const vec3 shadertoy_face_center[6] = vec3[6](";
+    for(uint32_t face = 0; face < 6; ++face) {
+        const auto& lb = cubeMapVertexPos[cubeMapVertexIndex[face][0]];
+        const auto& lt = cubeMapVertexPos[cubeMapVertexIndex[face][1]];
+        const auto& rt = cubeMapVertexPos[cubeMapVertexIndex[face][2]];
+        const auto& rb = cubeMapVertexPos[cubeMapVertexIndex[face][3]];
+        const char* separator = face ? ", vec3(" : "vec3(";
+        right += separator;
+        up += separator;
+        center += separator;
+        for(uint32_t k = 0; k < 3; ++k) {
+            // CubeMaps are always Y-flipped to match ShaderToy's UNPACK_FLIP_Y_WEBGL behavior
+            const auto sign = k == 1 ? -1.0f : 1.0f;
+            const char* end = k == 2 ? ")" : ", ";
+            right += std::to_string(sign * (rb[k] - lb[k]) * 0.5f) + end;
+            up += std::to_string(sign * (lt[k] - lb[k]) * 0.5f) + end;
+            center += std::to_string(sign * (lb[k] + rt[k]) * 0.5f) + end;
+        }
+    }
+    return right + ");\n" + up + ");\n" + center + ");\n";
+}
+
+// Lets the driver compile and link on its own threads. Completion is then polled with GL_COMPLETION_STATUS_KHR.
+static bool enableParallelShaderCompile() {
+    if(GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        return true;
+    }
+    if(GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        return true;
+    }
+    return false;
+}
 
 static void checkShaderCompileError(const GLuint shader, const std::string_view type) {
     GLint success;
@@ -141,13 +223,83 @@ static void checkShaderCompileError(const GLuint shader, const std::string_view
     }
 }
 
+struct GLFormat final {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    size_t pixelSize;
+};
+static GLFormat getGLFormat(const Format format) {
+    switch(format) {
+        case Format::RGBA16F:
+            return { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 4 * sizeof(uint16_t) };
+        case Format::RGBA8:
+            return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 * sizeof(uint8_t) };
+        case Format::R11G11B10F:
+            return { GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, sizeof(uint32_t) };
+        case Format::Auto:  // resolved by buildPipeline
+            [[fallthrough]];
+        case Format::RGBA32F:
+            [[fallthrough]];
+        default:
+            return { GL_RGBA32F, GL_RGBA, GL_FLOAT, 4 * sizeof(float) };
+    }
+}
+
+static void clearFrameBuffer(const GLuint fbo) {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glDisable(GL_SCISSOR_TEST);  // also applies to glClear
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+}
+
 class GLFrameBuffer final : public FrameBuffer {
     GLuint mFBO{};
     GLuint mTexture{};
+    GLFormat mFormat;
     uint32_t mWidth = 0, mHeight = 0;
+    bool mPreserveContents;
+
+    void allocate(const uint32_t width, const uint32_t height) {
+        glBindTexture(GL_TEXTURE_2D, mTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(mFormat.internalFormat), static_cast<GLsizei>(width),
+                     static_cast<GLsizei>(height), 0, mFormat.format, mFormat.type, nullptr);
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        mWidth = width;
+        mHeight = height;
+    }
+    // Scales the contents to the new size, so that feedback passes continue after a resize. The texture name is kept since
+    // the channels of the pipeline refer to it, hence the contents take a detour through a temporary copy. Texels are not
+    // interpolated, but state packed at fixed texels still moves.
+    void resample(const uint32_t width, const uint32_t height) {
+        const auto oldWidth = static_cast<GLint>(mWidth), oldHeight = static_cast<GLint>(mHeight);
+        GLuint copyFBO, copyTexture;
+        glGenFramebuffers(1, &copyFBO);
+        glGenTextures(1, &copyTexture);
+        glBindTexture(GL_TEXTURE_2D, copyTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(mFormat.internalFormat), oldWidth, oldHeight, 0, mFormat.format,
+                     mFormat.type, nullptr);
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        glBindFramebuffer(GL_FRAMEBUFFER, copyFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, copyTexture, 0);
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, copyFBO);
+        glBlitFramebuffer(0, 0, oldWidth, oldHeight, 0, 0, oldWidth, oldHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        allocate(width, height);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFBO);
+        glBlitFramebuffer(0, 0, oldWidth, oldHeight, 0, 0, static_cast<GLint>(width), static_cast<GLint>(height),
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+        glDeleteFramebuffers(1, &copyFBO);
+        glDeleteTextures(1, &copyTexture);
+    }
 
 public:
-    GLFrameBuffer() {
+    GLFrameBuffer(const Format format, const bool preserveContents)
+        : mFormat{ getGLFormat(format) }, mPreserveContents{ preserveContents } {
         glGenFramebuffers(1, &mFBO);
         glGenTextures(1, &mTexture);
         glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
@@ -166,12 +318,10 @@ public:
     }
     void bind(const uint32_t width, const uint32_t height) override {
         if(width != mWidth || height != mHeight) {
-            glBindTexture(GL_TEXTURE_2D, mTexture);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RGBA,
-                         GL_FLOAT, nullptr);
-            glBindTexture(GL_TEXTURE_2D, GL_NONE);
-            mWidth = width;
-            mHeight = height;
+            if(mPreserveContents && mWidth && mHeight)
+                resample(width, height);
+            else
+                allocate(width, height);
         }
         glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
         assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
@@ -183,45 +333,37 @@ public:
     [[nodiscard]] uintptr_t getTexture() const override {
         return mTexture;
     }
-};
-
-static constexpr uint32_t cubeMapRenderTargetSize = 1024;
-class GLCubeMapRenderTarget final {
-    GLuint mTex{};
-
-public:
-    GLCubeMapRenderTarget() {
-        glGenTextures(1, &mTex);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, mTex);
-        for(int32_t idx = 0; idx < 6; ++idx) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + idx, 0, GL_RGBA16F, static_cast<GLsizei>(cubeMapRenderTargetSize),
-                         static_cast<GLsizei>(cubeMapRenderTargetSize), 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
-        }
-        glBindTexture(GL_TEXTURE_CUBE_MAP, GL_NONE);
+    [[nodiscard]] GLuint getFBO() const noexcept {
+        return mFBO;
     }
-    GLCubeMapRenderTarget(const GLCubeMapRenderTarget&) = delete;
-    GLCubeMapRenderTarget(GLCubeMapRenderTarget&&) = delete;
-    GLCubeMapRenderTarget& operator=(const GLCubeMapRenderTarget&) = delete;
-    GLCubeMapRenderTarget& operator=(GLCubeMapRenderTarget&&) = delete;
-    ~GLCubeMapRenderTarget() {
-        glDeleteTextures(1, &mTex);
+    [[nodiscard]] size_t getMemoryUsage() const override {
+        return static_cast<size_t>(mWidth) * mHeight * mFormat.pixelSize;
     }
-    [[nodiscard]] GLuint getTexture() const {
-        return mTex;
+    void clear() override {
+        if(mWidth && mHeight)
+            clearFrameBuffer(mFBO);
     }
 };
 
+// Layered frame buffer over all six faces, gl_Layer selects the face
 class GLCubeMapFrameBuffer final : public FrameBuffer {
     GLuint mFBO{};
     GLuint mTexture{};
+    GLFormat mFormat;
+    uint32_t mSize;
 
 public:
-    GLCubeMapFrameBuffer(GLuint texture, uint32_t idx) : mTexture{ texture } {
-        glGenFramebuffers(1, &mFBO);
-        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    GLCubeMapFrameBuffer(const Format format, const uint32_t size) : mFormat{ getGLFormat(format) }, mSize{ size } {
+        glGenTextures(1, &mTexture);
         glBindTexture(GL_TEXTURE_CUBE_MAP, mTexture);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + idx, mTexture, 0);
+        for(int32_t idx = 0; idx < 6; ++idx) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + idx, 0, static_cast<GLint>(mFormat.internalFormat),
+                         static_cast<GLsizei>(mSize), static_cast<GLsizei>(mSize), 0, mFormat.format, mFormat.type, nullptr);
+        }
         glBindTexture(GL_TEXTURE_CUBE_MAP, GL_NONE);
+        glGenFramebuffers(1, &mFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexture, 0);
         glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
     }
     GLCubeMapFrameBuffer(const GLCubeMapFrameBuffer&) = delete;
@@ -230,6 +372,7 @@ public:
     GLCubeMapFrameBuffer& operator=(GLCubeMapFrameBuffer&&) = delete;
     ~GLCubeMapFrameBuffer() override {
         glDeleteFramebuffers(1, &mFBO);
+        glDeleteTextures(1, &mTexture);
     }
     void bind(const uint32_t, const uint32_t) override {
         glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
@@ -242,34 +385,273 @@ public:
     [[nodiscard]] uintptr_t getTexture() const override {
         return mTexture;
     }
+    [[nodiscard]] size_t getMemoryUsage() const override {
+        return static_cast<size_t>(mSize) * mSize * 6 * mFormat.pixelSize;
+    }
+    void clear() override {
+        clearFrameBuffer(mFBO);  // all layers
+    }
 };
 
-class RenderPass final {
+// Brackets every draw of a pass with GL_TIME_ELAPSED queries. Results are read back a few frames later so that
+// profiling never stalls the pipeline; frames are simply not measured while all query slots are still in flight.
+class GPUTimer final {
+    static constexpr uint32_t latency = 4;
+    static constexpr uint32_t historySize = 128;
+
+    uint32_t mDraws;
+    std::vector<GLuint> mQueries;
+    uint64_t mIssued = 0;
+    uint64_t mCollected = 0;
+    uint64_t mDiscarded = 0;
+    bool mActive = false;
+    std::array<float, historySize> mHistory{};
+    uint32_t mHistoryCount = 0;
+    uint32_t mHistoryCursor = 0;
+
+    [[nodiscard]] GLuint query(const uint64_t frame, const uint32_t draw) const {
+        return mQueries[static_cast<size_t>(frame % latency) * mDraws + draw];
+    }
+    void collect() {
+        while(mCollected != mIssued) {
+            for(uint32_t idx = 0; idx < mDraws; ++idx) {
+                GLuint available = GL_FALSE;
+                glGetQueryObjectuiv(query(mCollected, idx), GL_QUERY_RESULT_AVAILABLE, &available);
+                if(!available)
+                    return;
+            }
+            GLuint64 elapsed = 0;
+            for(uint32_t idx = 0; idx < mDraws; ++idx) {
+                GLuint64 time = 0;
+                glGetQueryObjectui64v(query(mCollected, idx), GL_QUERY_RESULT, &time);
+                elapsed += time;
+            }
+            if(mCollected >= mDiscarded) {
+                mHistory[mHistoryCursor] = static_cast<float>(static_cast<double>(elapsed) * 1e-6);
+                mHistoryCursor = (mHistoryCursor + 1) % historySize;
+                mHistoryCount = std::min(mHistoryCount + 1, historySize);
+            }
+            ++mCollected;
+        }
+    }
+
+public:
+    explicit GPUTimer(const uint32_t draws) : mDraws{ draws }, mQueries(static_cast<size_t>(latency) * draws) {
+        glGenQueries(static_cast<GLsizei>(mQueries.size()), mQueries.data());
+    }
+    GPUTimer(const GPUTimer&) = delete;
+    GPUTimer(GPUTimer&&) = delete;
+    GPUTimer& operator=(const GPUTimer&) = delete;
+    GPUTimer& operator=(GPUTimer&&) = delete;
+    ~GPUTimer() {
+        glDeleteQueries(static_cast<GLsizei>(mQueries.size()), mQueries.data());
+    }
+    void beginFrame() {
+        collect();
+        mActive = mIssued - mCollected < latency;
+    }
+    void begin(const uint32_t draw) const {
+        if(mActive)
+            glBeginQuery(GL_TIME_ELAPSED, query(mIssued, draw));
+    }
+    void end() const {
+        if(mActive)
+            glEndQuery(GL_TIME_ELAPSED);
+    }
+    void endFrame() {
+        if(mActive)
+            ++mIssued;
+    }
+    // total time of the latest measured frame, 0 if none
+    [[nodiscard]] float latest() {
+        collect();
+        return mHistoryCount ? mHistory[(mHistoryCursor + historySize - 1) % historySize] : 0.0f;
+    }
+    // drops the history and the frames still in flight
+    void reset() {
+        mDiscarded = mIssued;
+        mHistoryCount = mHistoryCursor = 0;
+    }
+    [[nodiscard]] PassStatistics summarize(std::string name) {
+        collect();
+        PassStatistics stats{ std::move(name), 0.0f, 0.0f, 0.0f, 0.0f };
+        if(mHistoryCount == 0)
+            return stats;
+        std::vector<float> samples{ mHistory.cbegin(), mHistory.cbegin() + mHistoryCount };
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for(const auto sample : samples)
+            sum += static_cast<double>(sample);
+        stats.mean = static_cast<float>(sum / static_cast<double>(samples.size()));
+        const auto percentile = [&](const double p) {
+            return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5)];
+        };
+        stats.p50 = percentile(0.50);
+        stats.p95 = percentile(0.95);
+        stats.p99 = percentile(0.99);
+        return stats;
+    }
+};
+
+// Rebuilds a mip chain only if level 0 was written since the last rebuild. Static assets are created with complete mip
+// chains and never written again, so they are never regenerated.
+class MipmapTracker final {
+    struct State final {
+        uint64_t written = 0;
+        uint64_t built = 0;
+    };
+    std::unordered_map<GLuint, State> mStates;
+    uint64_t mGeneration = 0;
+
+public:
+    void markWritten(const GLuint texture) {
+        mStates[texture].written = ++mGeneration;
+    }
+    [[nodiscard]] bool requireUpdate(const GLuint texture) {
+        const auto iter = mStates.find(texture);
+        if(iter == mStates.cend() || iter->second.built == iter->second.written)
+            return false;
+        iter->second.built = iter->second.written;
+        return true;
+    }
+};
+
+static GLuint createSampler(const Filter filter, const Wrap wrap, const TexType type) {
+    const GLint wrapMode = [&] {
+        switch(wrap) {
+            case Wrap::Clamp:
+                return GL_CLAMP_TO_EDGE;
+            case Wrap::Repeat:
+                return GL_REPEAT;
+        }
+        SHADERTOY_UNREACHABLE();
+    }();
+    const GLint minFilter = [&] {
+        switch(filter) {
+            case Filter::Mipmap:
+                return GL_LINEAR_MIPMAP_LINEAR;
+            case Filter::Nearest:
+                return GL_NEAREST;
+            case Filter::Linear:
+                return GL_LINEAR;
+        }
+        SHADERTOY_UNREACHABLE();
+    }();
+    const GLint magFilter = [&] {
+        switch(filter) {
+            case Filter::Nearest:
+                return GL_NEAREST;
+            case Filter::Mipmap:
+                [[fallthrough]];
+            case Filter::Linear:
+                return GL_LINEAR;
+        }
+        SHADERTOY_UNREACHABLE();
+    }();
+
+    GLuint sampler;
+    glGenSamplers(1, &sampler);
+    if(type == TexType::Tex3D)
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+    return sampler;
+}
+
+// linked programs are shared between pipelines rebuilt from each other
+class GLProgram final {
     GLuint mProgram;
-    std::vector<DoubleBufferedFB> mBuffers;
+
+public:
+    GLProgram() : mProgram{ glCreateProgram() } {}
+    GLProgram(const GLProgram&) = delete;
+    GLProgram(GLProgram&&) = delete;
+    GLProgram& operator=(const GLProgram&) = delete;
+    GLProgram& operator=(GLProgram&&) = delete;
+    ~GLProgram() {
+        glDeleteProgram(mProgram);
+    }
+    [[nodiscard]] GLuint get() const noexcept {
+        return mProgram;
+    }
+};
+
+// where a pass looks for its program before compiling it
+struct ProgramLookup final {
+    const DiskCache* cache;  // optional
+    uint64_t driverHash;     // identifies the driver and the app version
+    const std::unordered_map<uint64_t, std::shared_ptr<GLProgram>>& inherited;
+};
+
+class RenderPass final {
+    std::string mName;
+    uint64_t mSignature;
+    std::shared_ptr<GLProgram> mProgramObject;
+    GLuint mProgram;  // owned by mProgramObject
+    DoubleBufferedFB mBuffer;
     NodeType mType;
-    GLint mLocationResolution;
-    GLint mLocationTime;
-    GLint mLocationTimeDelta;
-    GLint mLocationFrameRate;
-    GLint mLocationFrame;
-    GLint mLocationMouse;
-    GLint mLocationDate;
+    ImVec2 mCubeMapSize;
     GLint mLocationChannel[4]{};
-    GLint mLocationChannelResolution[4]{};
     std::vector<Channel> mChannels;
+    std::vector<GLuint> mSamplers;
+    GPUTimer mTimer;
+    std::vector<std::pair<GLuint, std::string_view>> mShaders;  // attached until link()
+    bool mLinked = false;
+    const DiskCache* mProgramCache;
+    uint64_t mSourceHash;  // of the final sources and the driver
+
+    // the cached blob is the binary format followed by the program binary
+    [[nodiscard]] bool loadProgramBinary() const {
+        const auto blob = mProgramCache->load(mSourceHash);
+        if(!blob || blob->size() <= sizeof(GLenum))
+            return false;
+        GLenum format;
+        std::memcpy(&format, blob->data(), sizeof(format));
+        glProgramBinary(mProgram, format, blob->data() + sizeof(format), static_cast<GLsizei>(blob->size() - sizeof(format)));
+        GLint success = GL_FALSE;
+        glGetProgramiv(mProgram, GL_LINK_STATUS, &success);
+        return success == GL_TRUE;
+    }
+    void storeProgramBinary() const {
+        GLint length = 0;
+        glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(length <= 0)
+            return;
+        std::vector<uint8_t> blob(sizeof(GLenum) + static_cast<size_t>(length));
+        GLenum format = GL_NONE;
+        glGetProgramBinary(mProgram, length, nullptr, &format, blob.data() + sizeof(format));
+        std::memcpy(blob.data(), &format, sizeof(format));
+        if(!mProgramCache->store(mSourceHash, blob.data(), blob.size()))
+            Log(HelloImGui::LogLevel::Warning, "Cannot write the program cache");
+    }
+
+    void releaseShaders() {
+        for(auto& [shader, stage] : mShaders) {
+            glDetachShader(mProgram, shader);
+            glDeleteShader(shader);
+        }
+        mShaders.clear();
+    }
 
 public:
-    RenderPass(const std::string& src, NodeType type, std::vector<DoubleBufferedFB> buffer, std::vector<Channel> channels,
-               bool clampOutput)
-        : mBuffers{ std::move(buffer) }, mType{ type }, mChannels{ std::move(channels) } {
+    RenderPass(std::string name, const uint64_t signature, const std::string& src, NodeType type, const uint32_t faceSize,
+               DoubleBufferedFB buffer, std::vector<Channel> channels, std::vector<GLuint> samplers, bool clampOutput,
+               const ProgramLookup& lookup)
+        : mName{ std::move(name) }, mSignature{ signature }, mBuffer{ buffer }, mType{ type },
+          mCubeMapSize{ static_cast<float>(faceSize), static_cast<float>(faceSize) }, mChannels{ std::move(channels) },
+          mSamplers{ std::move(samplers) }, mTimer{ 1 }, mProgramCache{ lookup.cache } {
         std::string vertexSrc = shaderVersionDirective;
         std::string pixelSrc = shaderVersionDirective;
         if(type == NodeType::CubeMap) {
             vertexSrc += shaderCubeMapDef;
+            vertexSrc += getCubeMapFaceBasis();
             pixelSrc += shaderCubeMapDef;
         }
+        vertexSrc += shaderPassBlock;
         vertexSrc += shaderVertexSrc;
+        pixelSrc += shaderPassBlock;
         pixelSrc += shaderPixelHeader;
         for(auto& channel : mChannels) {
             pixelSrc += "uniform sampler";
@@ -284,224 +666,237 @@ public:
         pixelSrc += src;
         pixelSrc += shaderPixelFooter;
 
-        const auto vertexSrcData = vertexSrc.c_str();
-        const auto pixelSrcData = pixelSrc.c_str();
-
-        const auto shaderVertex = glCreateShader(GL_VERTEX_SHADER);
-        auto vertGuard = scopeExit([&] { glDeleteShader(shaderVertex); });
-        glShaderSource(shaderVertex, 1, &vertexSrcData, nullptr);
-        glCompileShader(shaderVertex);
-        checkShaderCompileError(shaderVertex, "VERTEX");
-
-        const auto shaderPixel = glCreateShader(GL_FRAGMENT_SHADER);
-        auto pixelGuard = scopeExit([&] { glDeleteShader(shaderPixel); });
-        glShaderSource(shaderPixel, 1, &pixelSrcData, nullptr);
-        glCompileShader(shaderPixel);
-        checkShaderCompileError(shaderPixel, "PIXEL");
-
-        mProgram = glCreateProgram();
-        auto programGuard = scopeFail([&] { glDeleteProgram(mProgram); });
-        glAttachShader(mProgram, shaderVertex);
-        auto vertBindGuard = scopeExit([&] { glDetachShader(mProgram, shaderVertex); });
-        glAttachShader(mProgram, shaderPixel);
-        auto pixelBindGuard = scopeExit([&] { glDetachShader(mProgram, shaderPixel); });
+        const auto geometrySrc = type == NodeType::CubeMap ? std::string{ shaderVersionDirective } + shaderGeometrySrc : "";
+
+        mSourceHash = hashString(pixelSrc, hashString(geometrySrc, hashString(vertexSrc, lookup.driverHash)));
+        if(const auto iter = lookup.inherited.find(mSourceHash); iter != lookup.inherited.cend()) {
+            mProgramObject = iter->second;
+            mProgram = mProgramObject->get();
+            return;
+        }
+        mProgramObject = std::make_shared<GLProgram>();
+        mProgram = mProgramObject->get();
+        if(mProgramCache) {
+            if(loadProgramBinary())
+                return;
+            glProgramParameteri(mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        // errors are only checked in link(), so that drivers with parallel compilation keep working in the background
+        const auto compile = [&](const GLenum stage, const std::string& source, const std::string_view name) {
+            const auto shader = glCreateShader(stage);
+            const auto sourceData = source.c_str();
+            glShaderSource(shader, 1, &sourceData, nullptr);
+            glCompileShader(shader);
+            mShaders.emplace_back(shader, name);
+        };
+        compile(GL_VERTEX_SHADER, vertexSrc, "VERTEX");
+        if(type == NodeType::CubeMap)
+            compile(GL_GEOMETRY_SHADER, geometrySrc, "GEOMETRY");
+        compile(GL_FRAGMENT_SHADER, pixelSrc, "PIXEL");
+
+        for(auto& [shader, stage] : mShaders)
+            glAttachShader(mProgram, shader);
         glLinkProgram(mProgram);
-        checkShaderCompileError(mProgram, "PROGRAM");
+    }
+    RenderPass(const RenderPass&) = delete;
+    RenderPass(RenderPass&&) = delete;
+    RenderPass& operator=(const RenderPass&) = delete;
+    RenderPass& operator=(RenderPass&&) = delete;
+    ~RenderPass() {
+        releaseShaders();
+    }
+    // never blocks, requires parallel shader compile
+    [[nodiscard]] bool isCompleted() const {
+        if(mShaders.empty())
+            return true;
+        GLint completed = GL_FALSE;
+        glGetProgramiv(mProgram, GL_COMPLETION_STATUS_KHR, &completed);
+        return completed == GL_TRUE;
+    }
+    // waits for the compilation, throws Error on failure
+    void link() {
+        if(mLinked)
+            return;
+        // nothing to check if the program was loaded from the cache
+        if(!mShaders.empty()) {
+            auto guard = scopeExit([&] { releaseShaders(); });
+            GLint success = GL_FALSE;
+            glGetProgramiv(mProgram, GL_LINK_STATUS, &success);
+            if(!success) {
+                // compile logs are more useful than the link log
+                for(auto& [shader, stage] : mShaders)
+                    checkShaderCompileError(shader, stage);
+                checkShaderCompileError(mProgram, "PROGRAM");
+            }
+            if(mProgramCache)
+                storeProgramBinary();
+        }
 
         auto& mLocationChannel0 = mLocationChannel[0];
         auto& mLocationChannel1 = mLocationChannel[1];
         auto& mLocationChannel2 = mLocationChannel[2];
         auto& mLocationChannel3 = mLocationChannel[3];
 #define SHADERTOY_GET_UNIFORM_LOCATION(NAME) mLocation##NAME = glGetUniformLocation(mProgram, "i" #NAME)
-        SHADERTOY_GET_UNIFORM_LOCATION(Resolution);
-        SHADERTOY_GET_UNIFORM_LOCATION(Time);
-        SHADERTOY_GET_UNIFORM_LOCATION(TimeDelta);
-        SHADERTOY_GET_UNIFORM_LOCATION(FrameRate);
-        SHADERTOY_GET_UNIFORM_LOCATION(Frame);
-        SHADERTOY_GET_UNIFORM_LOCATION(Mouse);
-        SHADERTOY_GET_UNIFORM_LOCATION(Date);
         SHADERTOY_GET_UNIFORM_LOCATION(Channel0);
         SHADERTOY_GET_UNIFORM_LOCATION(Channel1);
         SHADERTOY_GET_UNIFORM_LOCATION(Channel2);
         SHADERTOY_GET_UNIFORM_LOCATION(Channel3);
-        SHADERTOY_GET_UNIFORM_LOCATION(ChannelResolution[0]);
-        SHADERTOY_GET_UNIFORM_LOCATION(ChannelResolution[1]);
-        SHADERTOY_GET_UNIFORM_LOCATION(ChannelResolution[2]);
-        SHADERTOY_GET_UNIFORM_LOCATION(ChannelResolution[3]);
 #undef SHADERTOY_GET_UNIFORM_LOCATION
+        glUseProgram(mProgram);
+        for(auto& channel : mChannels) {
+            if(mLocationChannel[channel.slot] != -1)
+                glUniform1i(mLocationChannel[channel.slot], static_cast<GLint>(channel.slot));
+        }
+        glUseProgram(GL_NONE);
+
+        // GLSL 4.10 has no layout(binding) for uniform blocks
+        if(const auto index = glGetUniformBlockIndex(mProgram, "ShaderToyGlobal"); index != GL_INVALID_INDEX)
+            glUniformBlockBinding(mProgram, index, globalUniformBinding);
+        if(const auto index = glGetUniformBlockIndex(mProgram, "ShaderToyPass"); index != GL_INVALID_INDEX)
+            glUniformBlockBinding(mProgram, index, passUniformBinding);
+        mLinked = true;
     }
-    RenderPass(const RenderPass&) = delete;
-    RenderPass(RenderPass&&) = delete;
-    RenderPass& operator=(const RenderPass&) = delete;
-    RenderPass& operator=(RenderPass&&) = delete;
-    ~RenderPass() {
-        glDeleteProgram(mProgram);
+    [[nodiscard]] const std::string& getName() const noexcept {
+        return mName;
     }
-    [[nodiscard]] NodeType getType() const noexcept {
-        return mType;
+    [[nodiscard]] uint64_t getSignature() const noexcept {
+        return mSignature;
     }
-    void render(const ImVec2 frameBufferSize, const ImVec2 clipMin, const ImVec2 clipMax, const ImVec2 canvasSize,
-                const ShaderToyUniform& uniform, const GLuint vao, const GLuint vbo) {
-        glDisable(GL_BLEND);
-        constexpr ImVec2 cubeMapSize{ static_cast<float>(cubeMapRenderTargetSize), static_cast<float>(cubeMapRenderTargetSize) };
-        const auto screenBase = clipMin;
-        const auto screenSize = ImVec2{ clipMax.x - clipMin.x, clipMax.y - clipMin.y };
-
-        for(uint32_t idx = 0; idx < mBuffers.size(); ++idx) {
-            const auto buffer = mBuffers[idx].get();
-            ImVec2 size, base, fbSize, uniformSize;
-            if(buffer) {
-                base = { 0, 0 };
-                size = mType == NodeType::CubeMap ? cubeMapSize : screenSize;
-                fbSize = size;
-                uniformSize = mType == NodeType::CubeMap ? cubeMapSize : canvasSize;
-                glViewport(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y));
-                glDisable(GL_SCISSOR_TEST);
-                buffer->bind(static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y));
+    [[nodiscard]] uint64_t getSourceHash() const noexcept {
+        return mSourceHash;
+    }
+    [[nodiscard]] const std::shared_ptr<GLProgram>& getProgram() const noexcept {
+        return mProgramObject;
+    }
+    [[nodiscard]] DoubleBufferedFB getBuffer() const noexcept {
+        return mBuffer;
+    }
+    // advances the double buffers as if a frame was rendered
+    void skipFrame() {
+        mBuffer.get();
+        for(auto& channel : mChannels)
+            channel.tex.get();
+    }
+    [[nodiscard]] PassStatistics getStatistics() {
+        return mTimer.summarize(mName);
+    }
+    void resetStatistics() {
+        mTimer.reset();
+    }
+    [[nodiscard]] float getLatestTime() {
+        return mTimer.latest();
+    }
+    [[nodiscard]] PassUniformBlock getUniformBlock(const ImVec2 screenSize, const ImVec2 canvasSize) const {
+        const auto size = mType == NodeType::CubeMap ? mCubeMapSize : screenSize;
+        const auto uniformSize = mType == NodeType::CubeMap ? mCubeMapSize : canvasSize;
+        PassUniformBlock block{};
+        block.resolution[0] = uniformSize.x;
+        block.resolution[1] = uniformSize.y;
+        for(auto& channel : mChannels) {
+            auto& res = block.channelResolution[channel.slot];
+            if(channel.tex.type != TexType::Tex3D) {
+                const auto texSize = channel.size.value_or(size);
+                res[0] = texSize.x;
+                res[1] = texSize.y;
+                res[2] = 1.0f;
             } else {
-                glViewport(0, 0, static_cast<GLsizei>(frameBufferSize.x), static_cast<GLsizei>(frameBufferSize.y));
-                glEnable(GL_SCISSOR_TEST);
-                glScissor(static_cast<GLint>(clipMin.x), static_cast<GLint>(frameBufferSize.y - clipMax.y),
-                          static_cast<GLint>(clipMax.x - clipMin.x), static_cast<GLint>(clipMax.y - clipMin.y));
-                base = screenBase;
-                size = screenSize;
-                fbSize = frameBufferSize;
-                uniformSize = canvasSize;
+                res[0] = res[1] = res[2] = channel.size->x;
             }
-            glUseProgram(mProgram);
-            // update vertex array
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBindVertexArray(vao);
-            if(mType == NodeType::Image) {
-                std::array vertices{
-                    Vertex{ ImVec2{ base.x, base.y + size.y }, ImVec2{ 0.0, 0.0 } },                      // left-bottom
-                    Vertex{ ImVec2{ base.x, base.y }, ImVec2{ 0.0, uniformSize.y } },                     // left-top
-                    Vertex{ ImVec2{ base.x + size.x, base.y }, ImVec2{ uniformSize.x, uniformSize.y } },  // right-top
-                    Vertex{ ImVec2{ base.x + size.x, base.y + size.y }, ImVec2{ uniformSize.x, 0.0 } },   // right-bottom
-                };
-                for(auto& [pos, coord] : vertices) {
-                    pos.x = pos.x / fbSize.x * 2.0f - 1.0f;
-                    pos.y = 1.0f - pos.y / fbSize.y * 2.0f;
-                }
-                glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
-            } else {
-                std::array vertices{
-                    VertexCubeMap{ ImVec2{ base.x, base.y + size.y }, ImVec2{ 0.0, 0.0 },
-                                   cubeMapVertexPos[cubeMapVertexIndex[idx][0]] },  // left-bottom
-                    VertexCubeMap{ ImVec2{ base.x, base.y }, ImVec2{ 0.0, uniformSize.y },
-                                   cubeMapVertexPos[cubeMapVertexIndex[idx][1]] },  // left-top
-                    VertexCubeMap{ ImVec2{ base.x + size.x, base.y }, ImVec2{ uniformSize.x, uniformSize.y },
-                                   cubeMapVertexPos[cubeMapVertexIndex[idx][2]] },  // right-top
-                    VertexCubeMap{ ImVec2{ base.x + size.x, base.y + size.y }, ImVec2{ uniformSize.x, 0.0 },
-                                   cubeMapVertexPos[cubeMapVertexIndex[idx][3]] },  // right-bottom
-                };
-
-                // For Y-flipped cubemaps, also flip Y coordinates of all faces
-                // to match ShaderToy's UNPACK_FLIP_Y_WEBGL behavior
-                // CubeMaps are always Y-flipped
-                for(auto& [pos, coord, point] : vertices) {
-                    // Flip the 3D point's Y coordinate
-                    point[1] = -point[1];
-                }
+        }
+        return block;
+    }
+    [[nodiscard]] bool isOutput() const noexcept {
+        return mBuffer.t1 == nullptr;
+    }
+    // a pass with a buffer renders at bufferSize, the final pass into the clip rect of outputFBO
+    void render(const ImVec2 bufferSize, const ImVec2 frameBufferSize, const ImVec2 clipMin, const ImVec2 clipMax, const GLuint ubo,
+                const GLintptr uniformOffset, const GLuint outputFBO, MipmapTracker& mipmaps) {
+        glDisable(GL_BLEND);
+        const auto screenSize = ImVec2{ clipMax.x - clipMin.x, clipMax.y - clipMin.y };
 
-                for(auto& [pos, coord, point] : vertices) {
-                    pos.x = pos.x / fbSize.x * 2.0f - 1.0f;
-                    pos.y = 1.0f - pos.y / fbSize.y * 2.0f;
-                }
-                glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(VertexCubeMap), vertices.data(), GL_STREAM_DRAW);
+        glUseProgram(mProgram);
+        mTimer.beginFrame();
+        const auto buffer = mBuffer.get();
+        if(buffer) {
+            const auto size = mType == NodeType::CubeMap ? mCubeMapSize : bufferSize;
+            // the previous frame is resized along, so that this frame reads it at the new size
+            if(mBuffer.t2 != buffer) {
+                mBuffer.t2->bind(static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y));
+                mipmaps.markWritten(static_cast<GLuint>(mBuffer.t2->getTexture()));
             }
+            glViewport(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y));
+            glDisable(GL_SCISSOR_TEST);
+            buffer->bind(static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y));
+        } else {
+            glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+            glViewport(static_cast<GLint>(clipMin.x), static_cast<GLint>(frameBufferSize.y - clipMax.y),
+                       static_cast<GLsizei>(screenSize.x), static_cast<GLsizei>(screenSize.y));
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(static_cast<GLint>(clipMin.x), static_cast<GLint>(frameBufferSize.y - clipMax.y),
+                      static_cast<GLint>(screenSize.x), static_cast<GLint>(screenSize.y));
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, passUniformBinding, ubo, uniformOffset, sizeof(PassUniformBlock));
 
-            // update texture
-            for(auto& channel : mChannels) {
-                if(mLocationChannelResolution[channel.slot] == -1)
-                    continue;
-                if(channel.tex.type != TexType::Tex3D) {
-                    const auto texSize = channel.size.value_or(channel.tex.type == TexType::CubeMap ? cubeMapSize : size);
-                    glUniform3f(mLocationChannelResolution[channel.slot], texSize.x, texSize.y, 1.0f);
-                } else {
-                    const auto x = channel.size->x;
-                    glUniform3f(mLocationChannelResolution[channel.slot], x, x, x);
-                }
-            }
-            for(auto& channel : mChannels) {
-                if(mLocationChannel[channel.slot] == -1)
-                    continue;
-                glUniform1i(mLocationChannel[channel.slot], static_cast<GLint>(channel.slot));
-                glActiveTexture(GL_TEXTURE0 + channel.slot);
-                const auto type = channel.tex.type == TexType::CubeMap ? GL_TEXTURE_CUBE_MAP :
-                    channel.tex.type == TexType::Tex2D                 ? GL_TEXTURE_2D :
-                                                                         GL_TEXTURE_3D;
-                glBindTexture(type, static_cast<GLuint>(channel.tex.get()));
-                // updating
-                if(glGetError() != GL_NO_ERROR)
-                    continue;
-                const GLint wrapMode = [&] {
-                    switch(channel.wrapMode) {
-                        case Wrap::Clamp:
-                            return GL_CLAMP_TO_EDGE;
-                        case Wrap::Repeat:
-                            return GL_REPEAT;
-                    }
-                    SHADERTOY_UNREACHABLE();
-                }();
-                const GLint minFilter = [&] {
-                    switch(channel.filter) {
-                        case Filter::Mipmap:
-                            return GL_LINEAR_MIPMAP_LINEAR;
-                        case Filter::Nearest:
-                            return GL_NEAREST;
-                        case Filter::Linear:
-                            return GL_LINEAR;
-                    }
-                    SHADERTOY_UNREACHABLE();
-                }();
-                const GLint magFilter = [&] {
-                    switch(channel.filter) {
-                        case Filter::Nearest:
-                            return GL_NEAREST;
-                        case Filter::Mipmap:
-                            [[fallthrough]];
-                        case Filter::Linear:
-                            return GL_LINEAR;
-                    }
-                    SHADERTOY_UNREACHABLE();
-                }();
-                if(channel.filter == Filter::Mipmap)
-                    glGenerateMipmap(type);
-                if(channel.tex.type == TexType::Tex3D)
-                    glTexParameteri(type, GL_TEXTURE_WRAP_R, wrapMode);
-
-                glTexParameteri(type, GL_TEXTURE_WRAP_S, wrapMode);
-                glTexParameteri(type, GL_TEXTURE_WRAP_T, wrapMode);
-                glTexParameteri(type, GL_TEXTURE_MIN_FILTER, minFilter);
-                glTexParameteri(type, GL_TEXTURE_MAG_FILTER, magFilter);
-            }
+        // update texture
+        for(size_t channelIdx = 0; channelIdx < mChannels.size(); ++channelIdx) {
+            auto& channel = mChannels[channelIdx];
+            if(mLocationChannel[channel.slot] == -1)
+                continue;
+            glActiveTexture(GL_TEXTURE0 + channel.slot);
+            const auto type = channel.tex.type == TexType::CubeMap ? GL_TEXTURE_CUBE_MAP :
+                channel.tex.type == TexType::Tex2D                 ? GL_TEXTURE_2D :
+                                                                     GL_TEXTURE_3D;
+            const auto texture = static_cast<GLuint>(channel.tex.get());
+            glBindTexture(type, texture);
+            glBindSampler(channel.slot, mSamplers[channelIdx]);
+            if(channel.filter == Filter::Mipmap && mipmaps.requireUpdate(texture))
+                glGenerateMipmap(type);
+        }
 
-            // update uniform
-            if(mLocationResolution != -1)
-                glUniform3f(mLocationResolution, uniformSize.x, uniformSize.y, 0.0f);
-            if(mLocationTime != -1)
-                glUniform1f(mLocationTime, uniform.time);
-            if(mLocationTimeDelta != -1)
-                glUniform1f(mLocationTimeDelta, uniform.timeDelta);
-            if(mLocationFrameRate != -1)
-                glUniform1f(mLocationFrameRate, uniform.frameRate);
-            if(mLocationFrame != -1)
-                glUniform1i(mLocationFrame, uniform.frame);
-            if(mLocationMouse != -1)
-                glUniform4f(mLocationMouse, uniform.mouse.x, uniform.mouse.y, uniform.mouse.z, uniform.mouse.w);
-            if(mLocationDate != -1)
-                glUniform4f(mLocationDate, uniform.date.x, uniform.date.y, uniform.date.z, uniform.date.w);
-
-            glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-            if(buffer)
-                buffer->unbind();
+        mTimer.begin(0);
+        // one instance per face, routed to its layer by the geometry stage
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, mType == NodeType::CubeMap ? 6 : 1);
+        mTimer.end();
+        if(buffer) {
+            mipmaps.markWritten(static_cast<GLuint>(buffer->getTexture()));
+            buffer->unbind();
         }
+        mTimer.endFrame();
 
+        for(auto& channel : mChannels)
+            glBindSampler(channel.slot, GL_NONE);
         glActiveTexture(GL_TEXTURE0);  // restore
     }
 };
 
+static GLenum getInternalFormat(const BlockFormat format) {
+    switch(format) {
+        case BlockFormat::BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    }
+    SHADERTOY_UNREACHABLE();
+}
+
+// uploads the mip chain of one face, returns the start of the next one
+static const uint8_t* uploadCompressedFace(const GLenum target, const CompressedImage& image, const uint8_t* src) {
+    const auto levels = getMipLevels(image.width, image.height);
+    for(uint32_t level = 0, w = image.width, h = image.height; level < levels;
+        ++level, w = std::max(w >> 1, 1U), h = std::max(h >> 1, 1U)) {
+        const auto size = getCompressedLevelSize(image.format, w, h);
+        glCompressedTexImage2D(target, static_cast<GLint>(level), getInternalFormat(image.format), static_cast<GLsizei>(w),
+                               static_cast<GLsizei>(h), 0, static_cast<GLsizei>(size), src);
+        src += size;
+    }
+    return src;
+}
+
+bool isTextureCompressionSupported() {
+    return GLEW_EXT_texture_compression_s3tc;
+}
+
 class GLTextureObject final : public TextureObject {
     GLuint mTex{};
     ImVec2 mSize;
@@ -518,6 +913,13 @@ public:
         }
         glBindTexture(GL_TEXTURE_2D, GL_NONE);
     }
+    explicit GLTextureObject(const CompressedImage& image)
+        : mSize{ static_cast<float>(image.width), static_cast<float>(image.height) } {
+        glGenTextures(1, &mTex);
+        glBindTexture(GL_TEXTURE_2D, mTex);
+        uploadCompressedFace(GL_TEXTURE_2D, image, image.data.data());
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    }
     GLTextureObject(const GLTextureObject&) = delete;
     GLTextureObject(GLTextureObject&&) = delete;
     GLTextureObject& operator=(const GLTextureObject&) = delete;
@@ -537,6 +939,14 @@ std::unique_ptr<TextureObject> loadTexture(uint32_t width, uint32_t height, cons
     return std::make_unique<GLTextureObject>(width, height, data);
 }
 
+std::unique_ptr<TextureObject> loadTexture(const CompressedImage& image) {
+    if(!isTextureCompressionSupported()) {
+        const auto pixels = decompressImage(image);
+        return loadTexture(image.width, image.height, pixels.data());
+    }
+    return std::make_unique<GLTextureObject>(image);
+}
+
 class GLCubeMapObject final : public TextureObject {
     GLuint mTex{};
     ImVec2 mSize;
@@ -554,6 +964,15 @@ public:
         glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
         glBindTexture(GL_TEXTURE_CUBE_MAP, GL_NONE);
     }
+    explicit GLCubeMapObject(const CompressedImage& image)
+        : mSize{ static_cast<float>(image.width), static_cast<float>(image.width) } {
+        glGenTextures(1, &mTex);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, mTex);
+        auto src = image.data.data();
+        for(int32_t idx = 0; idx < 6; ++idx)
+            src = uploadCompressedFace(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(idx), image, src);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, GL_NONE);
+    }
     GLCubeMapObject(const GLCubeMapObject&) = delete;
     GLCubeMapObject(GLCubeMapObject&&) = delete;
     GLTextureObject& operator=(const GLCubeMapObject&) = delete;
@@ -573,6 +992,14 @@ std::unique_ptr<TextureObject> loadCubeMap(uint32_t size, const uint32_t* data)
     return std::make_unique<GLCubeMapObject>(size, data);
 }
 
+std::unique_ptr<TextureObject> loadCubeMap(const CompressedImage& image) {
+    if(!isTextureCompressionSupported()) {
+        const auto pixels = decompressImage(image);
+        return loadCubeMap(image.width, pixels.data());
+    }
+    return std::make_unique<GLCubeMapObject>(image);
+}
+
 class GLVolumeObject final : public TextureObject {
     GLuint mTex{};
     ImVec2 mSize;
@@ -611,109 +1038,660 @@ std::unique_ptr<TextureObject> loadVolume(uint32_t size, uint32_t channels, cons
     return std::make_unique<GLVolumeObject>(size, channels, data);
 }
 
-struct DynamicTexture final {
-    std::unique_ptr<GLTextureObject> tex;
-    std::vector<uint32_t> data;
-    std::function<void(uint32_t*)> update;
+// Persistently mapped upload buffer (ARB_buffer_storage) with one segment per frame in flight. A segment is only rewritten once
+// the GPU has consumed the uploads of the frame that used it.
+class GLStagingBuffer final {
+    static constexpr size_t segmentCount = 3;
+
+    GLuint mBuffer{};
+    uint8_t* mMapped = nullptr;
+    size_t mSegmentSize;
+    std::array<GLsync, segmentCount> mFences{};
+    size_t mSegment = 0;
+    size_t mOffset = 0;
+
+public:
+    explicit GLStagingBuffer(const size_t segmentSize) : mSegmentSize{ (segmentSize + 255) & ~static_cast<size_t>(255) } {
+        const auto size = static_cast<GLsizeiptr>(mSegmentSize * segmentCount);
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &mBuffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        mMapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    }
+    GLStagingBuffer(const GLStagingBuffer&) = delete;
+    GLStagingBuffer(GLStagingBuffer&&) = delete;
+    GLStagingBuffer& operator=(const GLStagingBuffer&) = delete;
+    GLStagingBuffer& operator=(GLStagingBuffer&&) = delete;
+    ~GLStagingBuffer() {
+        for(const auto fence : mFences)
+            if(fence)
+                glDeleteSync(fence);
+        if(mMapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+        }
+        glDeleteBuffers(1, &mBuffer);
+    }
+    [[nodiscard]] GLuint getBuffer() const noexcept {
+        return mBuffer;
+    }
+    void beginFrame() {
+        mOffset = 0;
+        auto& fence = mFences[mSegment];
+        if(!fence)
+            return;
+        while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    void endFrame() {
+        if(mOffset == 0)
+            return;  // the segment is still free
+        mFences[mSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mSegment = (mSegment + 1) % segmentCount;
+    }
+    // Copies height rows of width texels, stride texels apart. Returns their offset in the buffer, or nullopt if the segment is
+    // full.
+    [[nodiscard]] std::optional<GLintptr> stage(const uint32_t* data, const uint32_t width, const uint32_t height,
+                                                const uint32_t stride) {
+        const auto rowBytes = static_cast<size_t>(width) * sizeof(uint32_t);
+        if(!mMapped || mOffset + rowBytes * height > mSegmentSize)
+            return std::nullopt;
+        const auto offset = mSegment * mSegmentSize + mOffset;
+        for(uint32_t y = 0; y < height; ++y)
+            std::memcpy(mMapped + offset + y * rowBytes, data + static_cast<size_t>(y) * stride, rowBytes);
+        mOffset += rowBytes * height;
+        return static_cast<GLintptr>(offset);
+    }
 };
 
+// CPU-fed texture (e.g. the keyboard) with immutable storage, only the region reported by the update callback is uploaded
+class GLDynamicTexture final {
+    GLuint mTex{};
+    uint32_t mWidth, mHeight;
+    std::vector<uint32_t> mData;
+    DynamicTextureUpdate mUpdate;
+
+public:
+    GLDynamicTexture(const uint32_t width, const uint32_t height, DynamicTextureUpdate update)
+        : mWidth{ width }, mHeight{ height }, mData(static_cast<size_t>(width) * height), mUpdate{ std::move(update) } {
+        const auto w = static_cast<GLsizei>(width);
+        const auto h = static_cast<GLsizei>(height);
+        glGenTextures(1, &mTex);
+        glBindTexture(GL_TEXTURE_2D, mTex);
+        if(GLEW_ARB_texture_storage) {
+            // the full chain, so that mipmapped samplers stay complete
+            const auto levels = static_cast<GLsizei>(std::floor(std::log2(std::max(width, height)))) + 1;
+            glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, w, h);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, mData.data());
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, mData.data());  // R8G8B8A8
+        }
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    }
+    GLDynamicTexture(const GLDynamicTexture&) = delete;
+    GLDynamicTexture(GLDynamicTexture&&) = delete;
+    GLDynamicTexture& operator=(const GLDynamicTexture&) = delete;
+    GLDynamicTexture& operator=(GLDynamicTexture&&) = delete;
+    ~GLDynamicTexture() {
+        glDeleteTextures(1, &mTex);
+    }
+    [[nodiscard]] GLuint getTexture() const noexcept {
+        return mTex;
+    }
+    [[nodiscard]] size_t getByteSize() const noexcept {
+        return mData.size() * sizeof(uint32_t);
+    }
+    // returns false if nothing changed, staging is optional
+    bool update(GLStagingBuffer* staging) {
+        const auto region = mUpdate(mData.data());
+        if(region.empty())
+            return false;
+        assert(region.x + region.width <= mWidth && region.y + region.height <= mHeight);
+        const auto first = mData.data() + static_cast<size_t>(region.y) * mWidth + region.x;
+        const auto x = static_cast<GLint>(region.x);
+        const auto y = static_cast<GLint>(region.y);
+        const auto w = static_cast<GLsizei>(region.width);
+        const auto h = static_cast<GLsizei>(region.height);
+        glBindTexture(GL_TEXTURE_2D, mTex);
+        if(const auto offset = staging ? staging->stage(first, region.width, region.height, mWidth) : std::nullopt) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->getBuffer());
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE,
+                            reinterpret_cast<const void*>(*offset));  // NOLINT(performance-no-int-to-ptr)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+        } else {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(mWidth));
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, first);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        return true;
+    }
+};
+
+class GLPixelReadback final : public PixelReadback {
+    GLuint mPBO{};
+    GLsync mFence{};
+    uint32_t mWidth, mHeight;
+
+public:
+    // reads a rect of the bound read framebuffer
+    GLPixelReadback(const uint32_t width, const uint32_t height) : mWidth{ width }, mHeight{ height } {
+        glGenBuffers(1, &mPBO);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBO);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr, GL_STREAM_READ);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    GLPixelReadback(const GLPixelReadback&) = delete;
+    GLPixelReadback(GLPixelReadback&&) = delete;
+    GLPixelReadback& operator=(const GLPixelReadback&) = delete;
+    GLPixelReadback& operator=(GLPixelReadback&&) = delete;
+    ~GLPixelReadback() override {
+        glDeleteSync(mFence);
+        glDeleteBuffers(1, &mPBO);
+    }
+    [[nodiscard]] std::optional<std::vector<uint32_t>> poll() override {
+        if(glClientWaitSync(mFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+            return std::nullopt;
+        std::vector<uint32_t> pixels(static_cast<size_t>(mWidth) * mHeight);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mPBO);
+        if(const auto data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(pixels.size() * sizeof(uint32_t)),
+                                              GL_MAP_READ_BIT)) {
+            std::memcpy(pixels.data(), data, pixels.size() * sizeof(uint32_t));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        return pixels;
+    }
+    [[nodiscard]] ImVec2 size() const override {
+        return { static_cast<float>(mWidth), static_cast<float>(mHeight) };
+    }
+};
+
+// null if disabled by the SHADERTOY_NO_PROGRAM_CACHE environment variable, e.g. to measure cold compile times
+static const DiskCache* getProgramCache() {
+    if(const auto disabled = std::getenv("SHADERTOY_NO_PROGRAM_CACHE"); disabled && *disabled)  // NOLINT(concurrency-mt-unsafe)
+        return nullptr;
+    static const DiskCache cache{ "programs", 256ULL << 20 };
+    return &cache;
+}
+
 class OpenGLPipeline final : public Pipeline {
-    GLuint mVAOImage{};
-    GLuint mVAOCubeMap{};
-    GLuint mVBO{};
-    std::vector<std::unique_ptr<FrameBuffer>> mFrameBuffers;
-    std::vector<std::unique_ptr<GLCubeMapRenderTarget>> mCubeMapRenderTargets;
+    GLuint mVAO{};  // empty, core profile requires one to be bound for drawing
+    GLuint mGlobalUBO{};
+    GLuint mPassUBO{};
+    GLsizeiptr mPassUniformStride{};
+    std::vector<uint8_t> mPassUniformStaging;
+    std::vector<std::shared_ptr<FrameBuffer>> mFrameBuffers;  // feedback buffers may be shared with a rebuilt pipeline
     std::vector<std::unique_ptr<RenderPass>> mRenderPasses;
-    std::vector<DynamicTexture> mDynamicTextures;
+    std::vector<std::unique_ptr<GLDynamicTexture>> mDynamicTextures;
+    std::unique_ptr<GLStagingBuffer> mStaging;  // sized for all dynamic textures, created on first use if supported
+    MipmapTracker mMipmaps;
+    float mResolutionScale = 1.0f;
+    std::unique_ptr<GLFrameBuffer> mScaledOutput;   // the final pass renders here when mResolutionScale < 1
+    std::unique_ptr<GLFrameBuffer> mCaptureOutput;  // and here when the frame is captured, reused by later captures
+    bool mParallelShaderCompile;
+    bool mLinked = false;
+    const DiskCache* mProgramCache = nullptr;
+    uint64_t mDriverHash = 0;
+    uint64_t mFrameCount = 0;
+    // the pipeline this one is rebuilt from, the snapshot of its passes is released by link()
+    const OpenGLPipeline* mInheritedFrom = nullptr;
+    uint64_t mInheritedFrameCount = 0;
+    std::unordered_map<uint64_t, std::shared_ptr<GLProgram>> mInheritedPrograms;
+    std::unordered_map<std::string, std::pair<uint64_t, DoubleBufferedFB>> mInheritedPasses;
+    std::vector<std::shared_ptr<FrameBuffer>> mInheritedFrameBuffers;
+    // indexed by (Filter, Wrap, TexType), created on first use
+    std::array<GLuint, 3 * 2 * 3> mSamplers{};
+
+    GLuint getSampler(const Filter filter, const Wrap wrap, const TexType type) {
+        auto& sampler = mSamplers[(static_cast<size_t>(filter) * 2 + static_cast<size_t>(wrap)) * 3 + static_cast<size_t>(type)];
+        if(!sampler)
+            sampler = createSampler(filter, wrap, type);
+        return sampler;
+    }
+
+    void uploadGlobalUniforms(const ShaderToyUniform& uniform, const ImVec2 scale) {
+        const GlobalUniformBlock global{ { uniform.mouse.x * scale.x, uniform.mouse.y * scale.y, uniform.mouse.z * scale.x,
+                                           uniform.mouse.w * scale.y },
+                                         { uniform.date.x, uniform.date.y, uniform.date.z, uniform.date.w },
+                                         uniform.time,
+                                         uniform.timeDelta,
+                                         uniform.frameRate,
+                                         uniform.frame };
+        glBindBuffer(GL_UNIFORM_BUFFER, mGlobalUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(global), &global, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+    }
+
+    // Passes with a buffer render at bufferSize with the canvas scaled by bufferScale, the final pass renders into the clip rect
+    // of outputFBO with the canvas scaled by outputScale
+    void renderPasses(const ImVec2 bufferSize, const ImVec2 bufferScale, const ImVec2 frameBufferSize, const ImVec2 clipMin,
+                      const ImVec2 clipMax, const ImVec2 outputScale, const ImVec2 size, const ShaderToyUniform& uniform,
+                      const GLuint outputFBO) {
+        if(!mDynamicTextures.empty()) {
+            if(!mStaging && GLEW_ARB_buffer_storage) {
+                size_t size = 0;
+                for(auto& tex : mDynamicTextures)
+                    size += tex->getByteSize();
+                mStaging = std::make_unique<GLStagingBuffer>(size);
+            }
+            if(mStaging)
+                mStaging->beginFrame();
+            for(auto& tex : mDynamicTextures)
+                if(tex->update(mStaging.get()))
+                    mMipmaps.markWritten(tex->getTexture());
+            if(mStaging)
+                mStaging->endFrame();
+        }
+
+        // all uniforms of a frame are uploaded at once: one block shared by all passes, and one range per pass
+        uploadGlobalUniforms(uniform, bufferScale);
+        const ImVec2 bufferCanvas{ size.x * bufferScale.x, size.y * bufferScale.y };
+        const ImVec2 outputCanvas{ size.x * outputScale.x, size.y * outputScale.y };
+        const auto stride = static_cast<size_t>(mPassUniformStride);
+        mPassUniformStaging.resize(stride * mRenderPasses.size());
+        for(size_t idx = 0; idx < mRenderPasses.size(); ++idx) {
+            const auto& pass = mRenderPasses[idx];
+            const auto block = pass->getUniformBlock(bufferSize, pass->isOutput() ? outputCanvas : bufferCanvas);
+            std::memcpy(mPassUniformStaging.data() + idx * stride, &block, sizeof(block));
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, mPassUBO);
+        glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(mPassUniformStaging.size()), mPassUniformStaging.data(),
+                     GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, GL_NONE);
+        glBindBufferBase(GL_UNIFORM_BUFFER, globalUniformBinding, mGlobalUBO);
+
+        glBindVertexArray(mVAO);
+        const bool rescaleOutput = outputScale.x != bufferScale.x || outputScale.y != bufferScale.y;
+        for(size_t idx = 0; idx < mRenderPasses.size(); ++idx) {
+            const auto& pass = mRenderPasses[idx];
+            // the mouse position of the final pass is in its own pixels
+            if(rescaleOutput && pass->isOutput())
+                uploadGlobalUniforms(uniform, outputScale);
+            pass->render(bufferSize, frameBufferSize, clipMin, clipMax, mPassUBO, static_cast<GLintptr>(idx * stride), outputFBO,
+                         mMipmaps);
+        }
+        glBindVertexArray(GL_NONE);
+    }
+
+    // scales the image of source into the clip rect of outputFBO
+    static void blitToClipRect(const GLFrameBuffer& source, const ImVec2 sourceSize, const ImVec2 frameBufferSize,
+                               const ImVec2 clipMin, const ImVec2 clipMax, const GLuint outputFBO) {
+        const ImVec2 outputSize{ clipMax.x - clipMin.x, clipMax.y - clipMin.y };
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source.getFBO());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFBO);
+        const auto y0 = static_cast<GLint>(frameBufferSize.y - clipMax.y);
+        const auto y1 = static_cast<GLint>(frameBufferSize.y - clipMin.y);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(static_cast<GLint>(clipMin.x), y0, static_cast<GLsizei>(outputSize.x), static_cast<GLsizei>(outputSize.y));
+        glBlitFramebuffer(0, 0, static_cast<GLint>(sourceSize.x), static_cast<GLint>(sourceSize.y), static_cast<GLint>(clipMin.x),
+                          y0, static_cast<GLint>(clipMax.x), y1, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    // the size passes with a buffer render at for a clip rect of outputSize
+    [[nodiscard]] ImVec2 getBufferSize(const ImVec2 outputSize) const {
+        if(mResolutionScale >= 1.0f)
+            return outputSize;
+        return { std::max(1.0f, std::round(outputSize.x * mResolutionScale)),
+                 std::max(1.0f, std::round(outputSize.y * mResolutionScale)) };
+    }
 
 public:
-    explicit OpenGLPipeline() {
-        glGenBuffers(1, &mVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-
-        glGenVertexArrays(1, &mVAOImage);
-        glBindVertexArray(mVAOImage);
-        glEnableVertexAttribArray(0);
-        // NOLINTNEXTLINE(performance-no-int-to-ptr)
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, pos)));
-        glEnableVertexAttribArray(1);
-        // NOLINTNEXTLINE(performance-no-int-to-ptr)
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, coord)));
-        glBindVertexArray(0);
-
-        glGenVertexArrays(1, &mVAOCubeMap);
-        glBindVertexArray(mVAOCubeMap);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(VertexCubeMap),
-                              // NOLINTNEXTLINE(performance-no-int-to-ptr)
-                              reinterpret_cast<void*>(offsetof(VertexCubeMap, pos)));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexCubeMap),
-                              // NOLINTNEXTLINE(performance-no-int-to-ptr)
-                              reinterpret_cast<void*>(offsetof(VertexCubeMap, coord)));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(VertexCubeMap),
-                              // NOLINTNEXTLINE(performance-no-int-to-ptr)
-                              reinterpret_cast<void*>(offsetof(VertexCubeMap, point)));
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
+    explicit OpenGLPipeline() : mParallelShaderCompile{ enableParallelShaderCompile() } {
+        glGenVertexArrays(1, &mVAO);
+        glGenBuffers(1, &mGlobalUBO);
+        glGenBuffers(1, &mPassUBO);
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        mPassUniformStride = (static_cast<GLsizeiptr>(sizeof(PassUniformBlock)) + alignment - 1) / alignment * alignment;
+
+        // binaries are only valid for the driver that produced them
+        GLint binaryFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+        if(const auto cache = getProgramCache(); binaryFormats > 0 && cache && cache->isAvailable()) {
+            mProgramCache = cache;
+            mDriverHash = hashString(SHADERTOY_VERSION);
+            for(const auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+                const auto str = reinterpret_cast<const char*>(glGetString(name));
+                mDriverHash = hashString(str ? str : "", mDriverHash);
+            }
+        }
     }
     OpenGLPipeline(const OpenGLPipeline&) = delete;
     OpenGLPipeline(OpenGLPipeline&&) = delete;
     OpenGLPipeline& operator=(const OpenGLPipeline&) = delete;
     OpenGLPipeline& operator=(OpenGLPipeline&&) = delete;
     ~OpenGLPipeline() override {
-        glDeleteVertexArrays(1, &mVAOImage);
-        glDeleteVertexArrays(1, &mVAOCubeMap);
-        glDeleteBuffers(1, &mVBO);
+        glDeleteVertexArrays(1, &mVAO);
+        glDeleteBuffers(1, &mGlobalUBO);
+        glDeleteBuffers(1, &mPassUBO);
+        for(const auto sampler : mSamplers) {
+            if(sampler)
+                glDeleteSamplers(1, &sampler);
+        }
     }
 
-    FrameBuffer* createFrameBuffer() override {
-        mFrameBuffers.push_back(std::make_unique<GLFrameBuffer>());
+    FrameBuffer* createFrameBuffer(const Format format, const bool preserveContents) override {
+        mFrameBuffers.push_back(std::make_unique<GLFrameBuffer>(format, preserveContents));
         return mFrameBuffers.back().get();
     }
-    GLCubeMapRenderTarget* createCubeMapRenderTarget() {
-        mCubeMapRenderTargets.push_back(std::make_unique<GLCubeMapRenderTarget>());
-        return mCubeMapRenderTargets.back().get();
+    FrameBuffer* createCubeMapFrameBuffer(const Format format, const uint32_t faceSize) override {
+        mFrameBuffers.push_back(std::make_unique<GLCubeMapFrameBuffer>(format, faceSize));
+        return mFrameBuffers.back().get();
+    }
+
+    void addPass(const std::string& name, const uint64_t signature, const std::string& src, NodeType type, uint32_t faceSize,
+                 DoubleBufferedFB target, std::vector<Channel> channels, bool clampOutput) override {
+        std::vector<GLuint> samplers;
+        samplers.reserve(channels.size());
+        for(auto& channel : channels)
+            samplers.push_back(getSampler(channel.filter, channel.wrapMode, channel.tex.type));
+        mRenderPasses.push_back(std::make_unique<RenderPass>(name, signature, src, type, faceSize, target, std::move(channels),
+                                                             std::move(samplers), clampOutput,
+                                                             ProgramLookup{ mProgramCache, mDriverHash, mInheritedPrograms }));
+    }
+
+    void inherit(const Pipeline& previous) override {
+        const auto& pipeline = dynamic_cast<const OpenGLPipeline&>(previous);
+        mInheritedFrom = &pipeline;
+        mInheritedFrameCount = pipeline.mFrameCount;
+        for(const auto& pass : pipeline.mRenderPasses) {
+            mInheritedPrograms.emplace(pass->getSourceHash(), pass->getProgram());
+            mInheritedPasses.emplace(pass->getName(), std::make_pair(pass->getSignature(), pass->getBuffer()));
+        }
+        mInheritedFrameBuffers = pipeline.mFrameBuffers;
+    }
+    [[nodiscard]] std::optional<DoubleBufferedFB> inheritFrameBuffers(const std::string& name,
+                                                                     const uint64_t signature) override {
+        const auto iter = mInheritedPasses.find(name);
+        if(iter == mInheritedPasses.cend() || iter->second.first != signature)
+            return std::nullopt;
+        const auto buffer = iter->second.second;
+        if(buffer.t1 == buffer.t2)
+            return std::nullopt;
+        for(auto& frameBuffer : mInheritedFrameBuffers) {
+            if(frameBuffer.get() == buffer.t1 || frameBuffer.get() == buffer.t2)
+                mFrameBuffers.push_back(frameBuffer);
+        }
+        return buffer;
+    }
+    void takeOver(const Pipeline& previous) override {
+        if(&previous != mInheritedFrom)
+            return;
+        // the shared buffers were captured when this pipeline was built, and double buffers swap once per frame
+        if((mInheritedFrom->mFrameCount - mInheritedFrameCount) % 2 != 0) {
+            for(const auto& pass : mRenderPasses)
+                pass->skipFrame();
+        }
+        for(const auto& buffer : mFrameBuffers)
+            mMipmaps.markWritten(static_cast<GLuint>(buffer->getTexture()));
+        mInheritedFrom = nullptr;
+    }
+
+    [[nodiscard]] bool poll() override {
+        if(!mLinked) {
+            if(mParallelShaderCompile) {
+                for(const auto& pass : mRenderPasses) {
+                    if(!pass->isCompleted())
+                        return false;
+                }
+            }
+            link();
+        }
+        return true;
     }
-    std::vector<FrameBuffer*> createCubeMapFrameBuffer() override {
-        std::vector<FrameBuffer*> buffers;
-        const auto target = createCubeMapRenderTarget();
-        for(uint32_t idx = 0; idx < 6; ++idx) {
-            mFrameBuffers.push_back(std::make_unique<GLCubeMapFrameBuffer>(target->getTexture(), idx));
-            buffers.emplace_back(mFrameBuffers.back().get());
+    void link() override {
+        if(mLinked)
+            return;
+        for(const auto& pass : mRenderPasses) {
+            // TODO: error markers
+            auto guard = scopeFail([&] { Log(HelloImGui::LogLevel::Error, "Failed to compile shader %s", pass->getName().c_str()); });
+            pass->link();
         }
-        return buffers;
+        mLinked = true;
+        mInheritedPrograms.clear();
+        mInheritedPasses.clear();
+        mInheritedFrameBuffers.clear();
     }
 
-    void addPass(const std::string& src, NodeType type, std::vector<DoubleBufferedFB> target, std::vector<Channel> channels,
-                 bool clampOutput) override {
-        mRenderPasses.push_back(std::make_unique<RenderPass>(src, type, std::move(target), std::move(channels), clampOutput));
+    void clearFrameBuffers() override {
+        for(const auto& buffer : mFrameBuffers)
+            buffer->clear();
+    }
+    void setResolutionScale(const float scale) override {
+        mResolutionScale = std::clamp(scale, 0.0f, 1.0f);
+    }
+    [[nodiscard]] float getGPUFrameTime() override {
+        float time = 0.0f;
+        for(const auto& pass : mRenderPasses)
+            time += pass->getLatestTime();
+        return time;
     }
 
     void render(const ImVec2 frameBufferSize, const ImVec2 clipMin, const ImVec2 clipMax, ImVec2 size,
                 const ShaderToyUniform& uniform) override {
-        for(auto& [tex, data, update] : mDynamicTextures) {
-            update(data.data());
-            const auto texId = static_cast<GLuint>(tex->getTexture());
-            glBindTexture(GL_TEXTURE_2D, texId);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(tex->size().x), static_cast<GLsizei>(tex->size().y), 0,
-                         GL_RGBA, GL_UNSIGNED_BYTE, data.data());  // R8G8B8A8
-            glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        // the final pass draws into whatever framebuffer the caller has bound
+        link();
+        ++mFrameCount;
+        GLint outputFBO = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &outputFBO);
+        const ImVec2 outputSize{ clipMax.x - clipMin.x, clipMax.y - clipMin.y };
+        if(mResolutionScale < 1.0f) {
+            // render everything at the internal resolution, then upscale the final image into the clip rect
+            const auto scaledSize = getBufferSize(outputSize);
+            const ImVec2 scale{ scaledSize.x / outputSize.x, scaledSize.y / outputSize.y };
+            if(!mScaledOutput)
+                mScaledOutput = std::make_unique<GLFrameBuffer>(Format::RGBA8, false);
+            mScaledOutput->bind(static_cast<uint32_t>(scaledSize.x), static_cast<uint32_t>(scaledSize.y));
+            renderPasses(scaledSize, scale, scaledSize, ImVec2{ 0.0f, 0.0f }, scaledSize, scale, size, uniform,
+                         mScaledOutput->getFBO());
+            blitToClipRect(*mScaledOutput, scaledSize, frameBufferSize, clipMin, clipMax, static_cast<GLuint>(outputFBO));
+        } else {
+            mScaledOutput.reset();
+            renderPasses(outputSize, ImVec2{ 1.0f, 1.0f }, frameBufferSize, clipMin, clipMax, ImVec2{ 1.0f, 1.0f }, size, uniform,
+                         static_cast<GLuint>(outputFBO));
         }
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(outputFBO));
+    }
+    [[nodiscard]] std::unique_ptr<PixelReadback> capture(const ImVec2 frameBufferSize, const ImVec2 clipMin, const ImVec2 clipMax,
+                                                         const ImVec2 size, const ShaderToyUniform& uniform,
+                                                         const ImVec2 captureSize) override {
+        link();
+        ++mFrameCount;
+        GLint outputFBO = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &outputFBO);
+        // the feedback buffers keep their size and contents, only the final pass renders at captureSize
+        const ImVec2 outputSize{ clipMax.x - clipMin.x, clipMax.y - clipMin.y };
+        const auto bufferSize = getBufferSize(outputSize);
+        // the final pass overwrites every pixel, so a new size reallocates without copying the previous capture
+        if(!mCaptureOutput)
+            mCaptureOutput = std::make_unique<GLFrameBuffer>(Format::RGBA8, false);
+        mCaptureOutput->bind(static_cast<uint32_t>(captureSize.x), static_cast<uint32_t>(captureSize.y));
+        renderPasses(bufferSize, ImVec2{ bufferSize.x / outputSize.x, bufferSize.y / outputSize.y }, captureSize,
+                     ImVec2{ 0.0f, 0.0f }, captureSize, ImVec2{ captureSize.x / outputSize.x, captureSize.y / outputSize.y }, size,
+                     uniform, mCaptureOutput->getFBO());
+        blitToClipRect(*mCaptureOutput, captureSize, frameBufferSize, clipMin, clipMax, static_cast<GLuint>(outputFBO));
+        // still bound for reading after the blit
+        auto readback =
+            std::make_unique<GLPixelReadback>(static_cast<uint32_t>(captureSize.x), static_cast<uint32_t>(captureSize.y));
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(outputFBO));
+        return readback;
+    }
+
+    TextureId createDynamicTexture(uint32_t width, uint32_t height, DynamicTextureUpdate update) override {
+        const auto& tex = mDynamicTextures.emplace_back(std::make_unique<GLDynamicTexture>(width, height, std::move(update)));
+        mStaging.reset();  // resized on the next frame
+        mMipmaps.markWritten(tex->getTexture());
+        return tex->getTexture();
+    }
+
+    [[nodiscard]] std::vector<PassStatistics> getStatistics() override {
+        std::vector<PassStatistics> statistics;
+        statistics.reserve(mRenderPasses.size());
         for(const auto& pass : mRenderPasses)
-            pass->render(frameBufferSize, clipMin, clipMax, size, uniform,
-                         pass->getType() == NodeType::Image ? mVAOImage : mVAOCubeMap, mVBO);
+            statistics.push_back(pass->getStatistics());
+        return statistics;
     }
+    void resetStatistics() override {
+        for(const auto& pass : mRenderPasses)
+            pass->resetStatistics();
+    }
+    [[nodiscard]] size_t getFrameBufferMemory() const override {
+        size_t bytes = 0;
+        for(const auto& buffer : mFrameBuffers)
+            bytes += buffer->getMemoryUsage();
+        return bytes;
+    }
+};
+
+class GLRenderTarget final : public RenderTarget {
+    GLuint mFBO{};
+    GLuint mTexture{};
+    uint32_t mWidth, mHeight;
 
-    TextureId createDynamicTexture(uint32_t width, uint32_t height, std::function<void(uint32_t*)> update) override {
-        mDynamicTextures.push_back(DynamicTexture{ std::make_unique<GLTextureObject>(width, height, nullptr),
-                                                   std::vector<uint32_t>(static_cast<size_t>(width) * height),
-                                                   std::move(update) });
-        return mDynamicTextures.back().tex->getTexture();
+public:
+    GLRenderTarget(const uint32_t width, const uint32_t height) : mWidth{ width }, mHeight{ height } {
+        glGenTextures(1, &mTexture);
+        glBindTexture(GL_TEXTURE_2D, mTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, GL_NONE);
+        glGenFramebuffers(1, &mFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture, 0);
+        const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+        if(status != GL_FRAMEBUFFER_COMPLETE) {
+            glDeleteFramebuffers(1, &mFBO);
+            glDeleteTextures(1, &mTexture);
+            Log(HelloImGui::LogLevel::Error, "Incomplete render target (status 0x%x)", status);
+            throw Error{};
+        }
+    }
+    GLRenderTarget(const GLRenderTarget&) = delete;
+    GLRenderTarget(GLRenderTarget&&) = delete;
+    GLRenderTarget& operator=(const GLRenderTarget&) = delete;
+    GLRenderTarget& operator=(GLRenderTarget&&) = delete;
+    ~GLRenderTarget() override {
+        glDeleteFramebuffers(1, &mFBO);
+        glDeleteTextures(1, &mTexture);
+    }
+    void bind() override {
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+    }
+    void unbind() override {
+        glBindFramebuffer(GL_FRAMEBUFFER, GL_NONE);
+    }
+    [[nodiscard]] GLuint getFBO() const noexcept {
+        return mFBO;
+    }
+    void readPixels(uint32_t* data) const override {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mFBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, static_cast<GLsizei>(mWidth), static_cast<GLsizei>(mHeight), GL_RGBA, GL_UNSIGNED_BYTE, data);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+    }
+    [[nodiscard]] ImVec2 size() const override {
+        return { static_cast<float>(mWidth), static_cast<float>(mHeight) };
     }
 };
 
+std::unique_ptr<RenderTarget> createRenderTarget(uint32_t width, uint32_t height) {
+    return std::make_unique<GLRenderTarget>(width, height);
+}
+
+class GLReadbackRing final : public ReadbackRing {
+    struct Slot final {
+        GLuint pbo;
+        GLsync fence;
+    };
+    std::vector<Slot> mSlots;
+    size_t mHead = 0;  // oldest frame in flight
+    size_t mCount = 0;
+    uint32_t mWidth, mHeight;
+
+    [[nodiscard]] GLsizeiptr frameBytes() const noexcept {
+        return static_cast<GLsizeiptr>(mWidth) * mHeight * 4;
+    }
+
+public:
+    GLReadbackRing(const uint32_t width, const uint32_t height, const uint32_t depth)
+        : mSlots(depth, Slot{ 0, nullptr }), mWidth{ width }, mHeight{ height } {
+        for(auto& slot : mSlots) {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes(), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+    }
+    GLReadbackRing(const GLReadbackRing&) = delete;
+    GLReadbackRing(GLReadbackRing&&) = delete;
+    GLReadbackRing& operator=(const GLReadbackRing&) = delete;
+    GLReadbackRing& operator=(GLReadbackRing&&) = delete;
+    ~GLReadbackRing() override {
+        for(auto& slot : mSlots) {
+            if(slot.fence)
+                glDeleteSync(slot.fence);
+            glDeleteBuffers(1, &slot.pbo);
+        }
+    }
+    void push(const RenderTarget& target) override {
+        assert(!full());
+        auto& slot = mSlots[(mHead + mCount) % mSlots.size()];
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, dynamic_cast<const GLRenderTarget&>(target).getFBO());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, static_cast<GLsizei>(mWidth), static_cast<GLsizei>(mHeight), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, GL_NONE);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++mCount;
+    }
+    bool pop(uint32_t* data, const bool wait) override {
+        if(empty())
+            return false;
+        auto& slot = mSlots[mHead];
+        const GLuint64 timeout = wait ? 1'000'000'000 : 0;
+        while(true) {
+            const auto status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            if(status != GL_TIMEOUT_EXPIRED)
+                break;
+            if(!wait)
+                return false;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if(const auto mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes(), GL_MAP_READ_BIT)) {
+            std::memcpy(data, mapped, static_cast<size_t>(frameBytes()));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        mHead = (mHead + 1) % mSlots.size();
+        --mCount;
+        return true;
+    }
+    [[nodiscard]] bool empty() const noexcept override {
+        return mCount == 0;
+    }
+    [[nodiscard]] bool full() const noexcept override {
+        return mCount == mSlots.size();
+    }
+};
+
+std::unique_ptr<ReadbackRing> createReadbackRing(uint32_t width, uint32_t height, uint32_t depth) {
+    return std::make_unique<GLReadbackRing>(width, height, depth);
+}
+
 std::unique_ptr<Pipeline> createPipeline() {
     try {
         return std::make_unique<OpenGLPipeline>();
@@ -0,0 +1,350 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/PipelineBuilder.hpp"
+#include "shadertoy/DiskCache.hpp"
+#include "shadertoy/Support.hpp"
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <hello_imgui/hello_imgui.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+std::unique_ptr<Pipeline> buildPipeline(const PipelineDesc& desc, const Pipeline* previous) {
+    const auto& nodes = desc.nodes;
+    std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, const PipelineLink*>>> graph;
+    std::unordered_map<uint32_t, uint32_t> degree;
+    constexpr auto invalidRef = PipelineNode::invalidRef;
+    uint32_t directRenderNode = invalidRef;
+    uint32_t sinkNode = invalidRef;
+    for(auto& link : desc.links) {
+        graph[link.end].emplace_back(link.start, &link);
+        ++degree[link.start];
+        if(nodes[link.end].nodeClass == NodeClass::RenderOutput && nodes[link.start].nodeClass == NodeClass::GLSLShader) {
+            sinkNode = link.end;
+            directRenderNode = link.start;
+        }
+    }
+
+    if(sinkNode == invalidRef) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Exactly one shader should be connected to the final render output");
+        throw Error{};
+    }
+
+    std::unordered_set<uint32_t> visited;
+    std::queue<uint32_t> q;
+    std::vector<uint32_t> order;
+    q.push(sinkNode);
+    std::unordered_set<uint32_t> weakRef;
+    for(auto& node : nodes) {
+        if(node.nodeClass == NodeClass::LastFrame) {
+            if(node.lastFrame == invalidRef || node.lastFrame == directRenderNode) {
+                HelloImGui::Log(HelloImGui::LogLevel::Error, "Invalid reference");
+                throw Error{};
+            }
+            weakRef.insert(node.lastFrame);
+        }
+    }
+    for(auto node : weakRef) {
+        if(!degree.count(node))
+            q.push(node);
+    }
+    while(!q.empty()) {
+        auto u = q.front();
+        q.pop();
+        visited.insert(u);
+        order.push_back(u);
+
+        if(auto it = graph.find(u); it != graph.cend()) {
+            for(auto [v, link] : it->second) {
+                visited.insert(v);
+                if(--degree[v] == 0) {
+                    q.push(v);
+                }
+            }
+        }
+    }
+
+    if(visited.size() != order.size()) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Loop detected");
+        throw Error{};
+    }
+
+    std::reverse(order.begin(), order.end());
+
+    auto pipeline = createPipeline();
+    if(!pipeline) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to create pipeline");
+        throw Error{};
+    }
+    if(previous)
+        pipeline->inherit(*previous);
+    std::unordered_map<uint32_t, DoubleBufferedTex> textureMap;
+    std::unordered_map<uint32_t, ImVec2> textureSizeMap;
+    std::unordered_map<uint32_t, DoubleBufferedFB> frameBufferMap;
+    std::unordered_set<uint32_t> requireDoubleBuffer;
+    for(auto idx : order) {
+        if(nodes[idx].nodeClass == NodeClass::LastFrame)
+            requireDoubleBuffer.insert(nodes[idx].lastFrame);
+    }
+    // Single buffered outputs are live from their pass to the last pass reading them, so passes whose outputs never overlap
+    // share a frame buffer. Double buffered outputs are read by the next frame and keep their own.
+    std::unordered_map<uint32_t, size_t> lastUse;
+    std::unordered_set<uint32_t> readByBuffers;
+    for(size_t pos = 0; pos < order.size(); ++pos) {
+        lastUse[order[pos]] = pos;
+        if(auto it = graph.find(order[pos]); it != graph.cend()) {
+            for(auto [v, link] : it->second) {
+                lastUse[v] = pos;
+                if(order[pos] != directRenderNode)
+                    readByBuffers.insert(v);
+            }
+        }
+    }
+    // Auto is opted into per shader, new shaders of the editor use it. It keeps full precision for data passed between buffers or
+    // across frames, and assumes that the final pass maps its inputs to 8 bits per channel, so half precision is plenty for
+    // outputs only read by it. Shaders passing HDR or packed data to the final pass should pick a format explicitly.
+    const auto getFormat = [&](const uint32_t idx) {
+        auto& node = nodes[idx];
+        if(node.format != Format::Auto)
+            return node.format;
+        if(node.type == NodeType::CubeMap)
+            return Format::RGBA16F;
+        if(requireDoubleBuffer.count(idx) || readByBuffers.count(idx))
+            return Format::RGBA32F;
+        return Format::RGBA16F;
+    };
+    // (type, format, face size), the face size is 0 for images
+    using FrameBufferKey = std::tuple<NodeType, Format, uint32_t>;
+    const auto getFrameBufferKey = [&](const uint32_t idx) {
+        auto& node = nodes[idx];
+        return FrameBufferKey{ node.type, getFormat(idx), node.type == NodeType::CubeMap ? node.faceSize : 0 };
+    };
+    // only feedback buffers keep their contents on resize, the others are overwritten in the same frame anyway
+    const auto createFrameBuffer = [&](const FrameBufferKey& key, const bool feedback) {
+        const auto [type, format, faceSize] = key;
+        return type == NodeType::CubeMap ? pipeline->createCubeMapFrameBuffer(format, faceSize) :
+                                           pipeline->createFrameBuffer(format, feedback);
+    };
+    // identifies a pass across rebuilds: its source, its output and what is bound to its channels
+    const auto getSignature = [&](const uint32_t idx) {
+        auto& node = nodes[idx];
+        const auto [type, format, faceSize] = getFrameBufferKey(idx);
+        std::string signature = std::to_string(static_cast<uint32_t>(type)) + ' ' +
+            std::to_string(static_cast<uint32_t>(format)) + ' ' + std::to_string(faceSize) + ' ' +
+            std::to_string(requireDoubleBuffer.count(idx));
+        std::vector<std::string> inputs;
+        if(auto it = graph.find(idx); it != graph.cend()) {
+            for(auto [v, link] : it->second) {
+                auto& input = nodes[v];
+                inputs.push_back(std::to_string(link->slot) + ' ' + std::to_string(static_cast<uint32_t>(link->filter)) + ' ' +
+                                 std::to_string(static_cast<uint32_t>(link->wrapMode)) + ' ' +
+                                 std::to_string(static_cast<uint32_t>(input.nodeClass)) + ' ' + input.name + ' ' +
+                                 (input.lastFrame != invalidRef ? nodes[input.lastFrame].name : std::string{}));
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+        for(auto& input : inputs)
+            signature += '\n' + input;
+        return hashString(node.source, hashString(signature));
+    };
+    std::unordered_map<uint32_t, uint64_t> signatureMap;
+    std::map<FrameBufferKey, std::vector<FrameBuffer*>> freeFrameBuffers;
+    std::multimap<size_t, std::pair<FrameBufferKey, FrameBuffer*>> liveFrameBuffers;
+    const auto allocateFrameBuffer = [&](const FrameBufferKey& key) {
+        if(auto& pool = freeFrameBuffers[key]; !pool.empty()) {
+            const auto buffer = pool.back();
+            pool.pop_back();
+            return buffer;
+        }
+        return createFrameBuffer(key, false);
+    };
+    for(size_t pos = 0; pos < order.size(); ++pos) {
+        const auto idx = order[pos];
+        auto& node = nodes[idx];
+        if(node.nodeClass != NodeClass::GLSLShader)
+            continue;
+        if(node.type != NodeType::Image && node.type != NodeType::CubeMap) {
+            HelloImGui::Log(HelloImGui::LogLevel::Error, "Unsupported shader type");
+            throw Error{};
+        }
+        while(!liveFrameBuffers.empty() && liveFrameBuffers.begin()->first < pos) {
+            auto& [key, buffer] = liveFrameBuffers.begin()->second;
+            freeFrameBuffers[key].push_back(buffer);
+            liveFrameBuffers.erase(liveFrameBuffers.begin());
+        }
+
+        signatureMap.emplace(idx, getSignature(idx));
+        if(requireDoubleBuffer.count(idx)) {
+            if(const auto inherited = pipeline->inheritFrameBuffers(node.name, signatureMap.at(idx)))
+                frameBufferMap.emplace(idx, *inherited);
+            else {
+                const auto key = getFrameBufferKey(idx);
+                frameBufferMap.emplace(idx, DoubleBufferedFB{ createFrameBuffer(key, true), createFrameBuffer(key, true) });
+            }
+        } else if(idx != directRenderNode) {
+            const auto key = getFrameBufferKey(idx);
+            const auto buffer = allocateFrameBuffer(key);
+            frameBufferMap.emplace(idx, DoubleBufferedFB{ buffer });
+            liveFrameBuffers.emplace(lastUse.at(idx), std::make_pair(key, buffer));
+        } else {
+            assert(node.type == NodeType::Image);
+            frameBufferMap.emplace(idx, DoubleBufferedFB{ nullptr });
+        }
+    }
+
+    for(auto idx : order) {
+        auto& node = nodes[idx];
+        switch(node.nodeClass) {  // NOLINT(clang-diagnostic-switch-enum)
+            case NodeClass::GLSLShader: {
+                const auto target = frameBufferMap.at(idx);
+                std::vector<Channel> channels;
+                if(auto it = graph.find(idx); it != graph.cend()) {
+                    for(auto [v, link] : it->second) {
+                        std::optional<ImVec2> size = std::nullopt;
+                        if(auto iter = textureSizeMap.find(v); iter != textureSizeMap.cend())
+                            size = iter->second;
+                        channels.push_back(Channel{ link->slot, textureMap.at(v), link->filter, link->wrapMode, size });
+                    }
+                }
+                pipeline->addPass(node.name, signatureMap.at(idx), node.source, node.type, node.faceSize, target,
+                                  std::move(channels), idx == sinkNode);
+
+                if(target.t1) {
+                    auto texType = node.type == NodeType::CubeMap ? TexType::CubeMap : TexType::Tex2D;
+
+                    textureMap.emplace(idx, DoubleBufferedTex{ target.t1->getTexture(), target.t2->getTexture(), texType });
+                    if(node.type == NodeType::CubeMap)
+                        textureSizeMap.emplace(idx,
+                                               ImVec2{ static_cast<float>(node.faceSize), static_cast<float>(node.faceSize) });
+                }
+
+                break;
+            }
+            case NodeClass::LastFrame: {
+                const auto ref = node.lastFrame;
+                auto target = frameBufferMap.at(ref);
+                assert(target.t1 && target.t2);
+                if(nodes[ref].type == NodeType::CubeMap)
+                    textureSizeMap.emplace(idx, ImVec2{ static_cast<float>(nodes[ref].faceSize),
+                                                        static_cast<float>(nodes[ref].faceSize) });
+                textureMap.emplace(idx,
+                                   DoubleBufferedTex{ target.t2->getTexture(), target.t1->getTexture(),
+                                                      nodes[ref].type == NodeType::CubeMap ? TexType::CubeMap : TexType::Tex2D });
+                break;
+            }
+            case NodeClass::RenderOutput: {
+                break;
+            }
+            case NodeClass::Texture: {
+                textureSizeMap.emplace(idx, node.texture->size());
+                textureMap.emplace(idx, DoubleBufferedTex{ node.texture->getTexture(), TexType::Tex2D });
+                break;
+            }
+            case NodeClass::CubeMap: {
+                textureSizeMap.emplace(idx, node.texture->size());
+                textureMap.emplace(idx, DoubleBufferedTex{ node.texture->getTexture(), TexType::CubeMap });
+                break;
+            }
+            case NodeClass::Volume: {
+                textureSizeMap.emplace(idx, node.texture->size());
+                textureMap.emplace(idx, DoubleBufferedTex{ node.texture->getTexture(), TexType::Tex3D });
+                break;
+            }
+            case NodeClass::Keyboard: {
+                DynamicTextureUpdate update = desc.keyboard;
+                if(!update)
+                    update = [](uint32_t*) { return TextureRegion{}; };
+                textureSizeMap.emplace(idx, ImVec2{ 256, 3 });
+                textureMap.emplace(idx, DoubleBufferedTex{ pipeline->createDynamicTexture(256, 3, update), TexType::Tex2D });
+                break;
+            }
+            default:
+                reportNotImplemented();
+        }
+    }
+
+    return pipeline;
+}
+
+PipelineDesc describePipeline(const ShaderToyTransmissionFormat& sttf, std::vector<std::unique_ptr<TextureObject>>& textures) {
+    PipelineDesc desc;
+    std::unordered_map<const Node*, uint32_t> nodeMap;
+    for(auto& node : sttf.nodes) {
+        nodeMap.emplace(node.get(), static_cast<uint32_t>(desc.nodes.size()));
+        PipelineNode& descNode = desc.nodes.emplace_back();
+        descNode.name = node->name;
+        descNode.nodeClass = node->getNodeClass();
+        descNode.type = node->getNodeType();
+        switch(node->getNodeClass()) {  // NOLINT(clang-diagnostic-switch-enum)
+            case NodeClass::GLSLShader: {
+                const auto& shader = dynamic_cast<const GLSLShader&>(*node);
+                descNode.source = shader.source;
+                descNode.format = shader.format;
+                descNode.faceSize = shader.faceSize;
+                break;
+            }
+            case NodeClass::Texture: {
+                const auto& texture = dynamic_cast<const Texture&>(*node);
+                textures.push_back(texture.compressed ? loadTexture(*texture.compressed) :
+                                                        loadTexture(texture.width, texture.height, texture.pixel.data()));
+                descNode.texture = textures.back().get();
+                break;
+            }
+            case NodeClass::CubeMap: {
+                const auto& texture = dynamic_cast<const CubeMap&>(*node);
+                textures.push_back(texture.compressed ? loadCubeMap(*texture.compressed) :
+                                                        loadCubeMap(texture.size, texture.pixel.data()));
+                descNode.texture = textures.back().get();
+                break;
+            }
+            case NodeClass::Volume: {
+                const auto& texture = dynamic_cast<const Volume&>(*node);
+                textures.push_back(loadVolume(texture.size, texture.channels, texture.pixel.data()));
+                descNode.texture = textures.back().get();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    for(auto& node : sttf.nodes) {
+        if(node->getNodeClass() == NodeClass::LastFrame) {
+            const auto ref = dynamic_cast<const LastFrame&>(*node).refNode;
+            desc.nodes[nodeMap.at(node.get())].lastFrame = ref ? nodeMap.at(ref) : PipelineNode::invalidRef;
+        }
+    }
+    for(auto& [start, end, filter, wrapMode, slot] : sttf.links)
+        desc.links.push_back(PipelineLink{ nodeMap.at(start), nodeMap.at(end), filter, wrapMode, slot });
+    return desc;
+}
+
+ShaderToyUniform offlineUniform(const int32_t frame, const float fps, const float startTime) {
+    const auto timeDelta = 1.0f / fps;
+    const auto time = startTime + static_cast<float>(frame) * timeDelta;
+    // iDate is pinned to 2000-01-01 so that the output is reproducible
+    return { time, timeDelta, fps, frame, ImVec4{ 0.0f, 0.0f, -1.0f, -1.0f }, ImVec4{ 2000.0f, 0.0f, 1.0f, time } };
+}
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,65 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Backend.hpp"
+#include "shadertoy/Config.hpp"
+#include "shadertoy/STTF.hpp"
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+// Render graph shared by the editor and the offline tools. Nodes refer to each other by index.
+struct PipelineNode final {
+    static constexpr uint32_t invalidRef = std::numeric_limits<uint32_t>::max();
+
+    std::string name;
+    NodeClass nodeClass;
+    NodeType type;
+    std::string source;                      // GLSLShader
+    Format format = Format::RGBA32F;         // GLSLShader
+    uint32_t faceSize = GLSLShader::defaultFaceSize;  // GLSLShader (CubeMap)
+    const TextureObject* texture = nullptr;  // Texture/CubeMap/Volume
+    uint32_t lastFrame = invalidRef;         // LastFrame
+};
+
+struct PipelineLink final {
+    uint32_t start;
+    uint32_t end;
+    Filter filter;
+    Wrap wrapMode;
+    uint32_t slot;
+};
+
+struct PipelineDesc final {
+    std::vector<PipelineNode> nodes;
+    std::vector<PipelineLink> links;
+    DynamicTextureUpdate keyboard;  // updates the 256x3 keyboard texture, optional
+};
+
+// If previous is given, passes with unchanged sources reuse its programs, and passes whose source, output and inputs are all
+// unchanged keep the contents of their feedback buffers. See Pipeline::inherit.
+std::unique_ptr<Pipeline> buildPipeline(const PipelineDesc& desc, const Pipeline* previous = nullptr);
+
+// Uploads the textures referenced by sttf and describes its graph. The returned description refers to textures.
+PipelineDesc describePipeline(const ShaderToyTransmissionFormat& sttf, std::vector<std::unique_ptr<TextureObject>>& textures);
+
+// Uniforms of a fixed-timestep frame, used by the offline tools and the video export
+ShaderToyUniform offlineUniform(int32_t frame, float fps, float startTime);
+
+SHADERTOY_NAMESPACE_END
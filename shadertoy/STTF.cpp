@@ -13,8 +13,18 @@
 */
 
 #include "shadertoy/STTF.hpp"
+#include "shadertoy/Base64.hpp"
+#include "shadertoy/DiskCache.hpp"
 #include "shadertoy/Support.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
 
 #include "shadertoy/SuppressWarningPush.hpp"
 
@@ -22,192 +32,703 @@
 #include <hello_imgui/hello_imgui.h>
 #include <magic_enum.hpp>
 #include <nlohmann/json.hpp>
+#include <zstd.h>
+
+#if defined(SHADERTOY_WINDOWS)
+#define NOMINMAX  // NOLINT(clang-diagnostic-unused-macros)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "shadertoy/SuppressWarningPop.hpp"
 
 SHADERTOY_NAMESPACE_BEGIN
 
-void ShaderToyTransmissionFormat::load(const std::string& filePath) {
-    std::ifstream file{ filePath };
-    if(!file) {
-        Log(HelloImGui::LogLevel::Error, "Cannot open file %s", filePath.c_str());
-        throw Error{};
+// Binary layout: BinaryHeader, the JSON graph (headerSize bytes), then the chunks starting at the next multiple of
+// chunkAlignment. The graph is the same as in the text format, except that nodes refer to a chunk by index instead of
+// embedding base64 data. Chunk offsets are relative to the start of the first chunk.
+struct BinaryHeader final {
+    static constexpr uint32_t magicValue = 0x42545453;  // STTB
+    static constexpr uint32_t currentVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint64_t headerSize;
+};
+static constexpr size_t chunkAlignment = 64;
+static constexpr int compressionLevel = 9;
+
+enum class ChunkCompression { None, Zstd };
+
+static size_t alignChunk(const size_t offset) {
+    return (offset + chunkAlignment - 1) / chunkAlignment * chunkAlignment;
+}
+
+static bool isBinarySTTF(const std::string& filePath) {
+    constexpr std::string_view extension = ".sttfb";
+    return filePath.size() >= extension.size() &&
+        filePath.compare(filePath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+// Read-only mapping of a whole file
+class MappedFile final {
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+#if defined(SHADERTOY_WINDOWS)
+    HANDLE mFile = INVALID_HANDLE_VALUE;
+    HANDLE mMapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string& filePath) {
+#if defined(SHADERTOY_WINDOWS)
+        mFile =
+            CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER size{};
+        if(mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size)) {
+            Log(HelloImGui::LogLevel::Error, "Cannot open file %s", filePath.c_str());
+            throw Error{};
+        }
+        mSize = static_cast<size_t>(size.QuadPart);
+        if(mSize == 0)
+            return;
+        mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mMapping)
+            mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        if(!mData) {
+            Log(HelloImGui::LogLevel::Error, "Cannot map file %s", filePath.c_str());
+            throw Error{};
+        }
+#else
+        const auto fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT(cppcoreguidelines-pro-type-vararg)
+        struct stat status {};
+        if(fd < 0 || fstat(fd, &status) != 0) {
+            if(fd >= 0)
+                close(fd);
+            Log(HelloImGui::LogLevel::Error, "Cannot open file %s", filePath.c_str());
+            throw Error{};
+        }
+        mSize = static_cast<size_t>(status.st_size);
+        if(mSize != 0) {
+            const auto data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED)  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                mData = static_cast<const uint8_t*>(data);
+        }
+        close(fd);  // the mapping keeps the file alive
+        if(mSize != 0 && !mData) {
+            Log(HelloImGui::LogLevel::Error, "Cannot map file %s", filePath.c_str());
+            throw Error{};
+        }
+#endif
     }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    ~MappedFile() {
+#if defined(SHADERTOY_WINDOWS)
+        if(mData)
+            UnmapViewOfFile(mData);
+        if(mMapping)
+            CloseHandle(mMapping);
+        if(mFile != INVALID_HANDLE_VALUE)
+            CloseHandle(mFile);
+#else
+        if(mData)
+            munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+    }
+    [[nodiscard]] const uint8_t* data() const noexcept {
+        return mData;
+    }
+    [[nodiscard]] size_t size() const noexcept {
+        return mSize;
+    }
+};
 
-    try {
-        nlohmann::json json;
-        file >> json;
-
-        json.at("metadata").get_to(metadata);
-        std::unordered_map<std::string, Node*> nodeMap;
-        for(auto node : json.at("nodes")) {
-            std::unique_ptr<Node> nodeVal;
-            // NOLINTNEXTLINE(clang-diagnostic-switch-enum)
-            switch(magic_enum::enum_cast<NodeClass>(node.at("class").get<std::string>()).value_or(NodeClass::Unknown)) {
-                case NodeClass::RenderOutput: {
-                    nodeVal = std::make_unique<RenderOutput>();
-                    break;
-                }
-                case NodeClass::GLSLShader: {
-                    nodeVal =
-                        std::make_unique<GLSLShader>(node.at("source").get<std::string>(),
-                                                     // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-                                                     magic_enum::enum_cast<NodeType>(node.at("type").get<std::string>()).value());
-                    break;
-                }
-                case NodeClass::Texture: {
-                    const auto width = node.at("width").get<uint32_t>();
-                    const auto height = node.at("height").get<uint32_t>();
-                    const auto base64Data = node.at("data").get<std::string>();
-                    const auto decodedData = base64_decode(base64Data);
-                    const auto begin = reinterpret_cast<const uint32_t*>(decodedData.data());
-                    const auto end = begin + static_cast<ptrdiff_t>(width) * height;
-                    nodeVal = std::make_unique<Texture>(width, height, std::vector<uint32_t>{ begin, end });
-                    break;
-                }
-                case NodeClass::CubeMap: {
-                    const auto size = node.at("size").get<uint32_t>();
-                    const auto base64Data = node.at("data").get<std::string>();
-                    const auto decodedData = base64_decode(base64Data);
-                    const auto begin = reinterpret_cast<const uint32_t*>(decodedData.data());
-                    const auto end = begin + static_cast<ptrdiff_t>(size) * size * 6;
-                    nodeVal = std::make_unique<CubeMap>(size, std::vector<uint32_t>{ begin, end });
-                    break;
-                }
-                case NodeClass::Volume: {
-                    const auto size = node.at("size").get<uint32_t>();
-                    const auto channels = node.at("channels").get<uint32_t>();
-                    const auto base64Data = node.at("data").get<std::string>();
-                    const auto decodedData = base64_decode(base64Data);
-                    const auto begin = reinterpret_cast<const uint8_t*>(decodedData.data());
-                    const auto end = begin + static_cast<ptrdiff_t>(size) * size * size * channels;
-                    nodeVal = std::make_unique<Volume>(size, channels, std::vector<uint8_t>{ begin, end });
-                    break;
-                }
-                case NodeClass::LastFrame: {
-                    nodeVal =
-                        std::make_unique<LastFrame>(node.at("ref").get<std::string>(),
-                                                    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-                                                    magic_enum::enum_cast<NodeType>(node.at("type").get<std::string>()).value());
-                    break;
-                }
-                case NodeClass::Keyboard: {
-                    nodeVal = std::make_unique<Keyboard>();
-                    break;
-                }
-                default: {
-                    Log(HelloImGui::LogLevel::Error, "Unknown node class %s", node.at("class").get<std::string>().c_str());
-                    throw Error{};
+// Decodes the texture data of asset nodes on worker threads, into the buffers already owned by the nodes. The largest assets
+// are started first. Failed tasks return a message instead of logging it, so that only the thread finishing the decoder logs.
+class AssetDecoder final {
+public:
+    using Task = std::function<std::optional<std::string>()>;
+
+private:
+    struct Entry final {
+        size_t cost;
+        Task task;
+    };
+
+    std::unique_ptr<MappedFile> mFile;  // referenced by the tasks
+    std::vector<std::string> mEncoded;  // base64 "data" strings of the text format
+    std::vector<Entry> mEntries;
+    size_t mTotalCost = 0;
+    std::atomic<size_t> mNext{ 0 };
+    std::atomic<size_t> mFinished{ 0 };
+    std::atomic<size_t> mFinishedCost{ 0 };
+    std::mutex mMutex;
+    std::string mError;  // of the first failed task
+    std::vector<std::thread> mWorkers;
+
+    void run() {
+        for(auto idx = mNext++; idx < mEntries.size(); idx = mNext++) {
+            auto& entry = mEntries[idx];
+            if(auto error = entry.task()) {
+                std::lock_guard lock{ mMutex };
+                if(mError.empty())
+                    mError = std::move(*error);
+            }
+            entry.task = nullptr;
+            mFinishedCost += entry.cost;
+            ++mFinished;
+        }
+    }
+    void join() {
+        for(auto& worker : mWorkers)
+            worker.join();
+        mWorkers.clear();
+    }
+
+public:
+    explicit AssetDecoder(std::unique_ptr<MappedFile> file) : mFile{ std::move(file) } {}
+    AssetDecoder(const AssetDecoder&) = delete;
+    AssetDecoder(AssetDecoder&&) = delete;
+    AssetDecoder& operator=(const AssetDecoder&) = delete;
+    AssetDecoder& operator=(AssetDecoder&&) = delete;
+    ~AssetDecoder() {
+        mNext = mEntries.size();  // drops the tasks that have not started yet
+        join();
+    }
+    [[nodiscard]] const MappedFile& file() const noexcept {
+        return *mFile;
+    }
+    [[nodiscard]] std::vector<std::string>& encoded() noexcept {
+        return mEncoded;
+    }
+    // cost is the decoded size in bytes
+    void addTask(const size_t cost, Task task) {
+        mEntries.push_back(Entry{ cost, std::move(task) });
+        mTotalCost += cost;
+    }
+    void start() {
+        std::stable_sort(mEntries.begin(), mEntries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.cost > rhs.cost; });
+        const auto workers = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1U), mEntries.size());
+        for(size_t idx = 0; idx < workers; ++idx)
+            mWorkers.emplace_back([this] { run(); });
+    }
+    [[nodiscard]] bool isFinished() const noexcept {
+        return mFinished == mEntries.size();
+    }
+    [[nodiscard]] float getProgress() const noexcept {
+        return mTotalCost == 0 ? 1.0f : static_cast<float>(static_cast<double>(mFinishedCost) / static_cast<double>(mTotalCost));
+    }
+    void finish() {
+        join();
+        if(!mError.empty()) {
+            Log(HelloImGui::LogLevel::Error, "%s", mError.c_str());
+            throw Error{};
+        }
+    }
+};
+
+// Fills size bytes at dst with the texture data of a node. The buffer must stay alive until the AssetDecoder finished, moving
+// the vector that owns it into the node is fine.
+using ReadData = std::function<void(const nlohmann::json& node, uint8_t* dst, size_t size)>;
+// stores the texture data of a node
+using WriteData = std::function<void(nlohmann::json& node, const uint8_t* data, size_t size)>;
+
+static void parseGraph(ShaderToyTransmissionFormat& sttf, const nlohmann::json& json, const ReadData& readData) {
+    const auto readTexels = [&](const nlohmann::json& node, const size_t count) {
+        std::vector<uint32_t> texels(count);  // R8G8B8A8
+        readData(node, reinterpret_cast<uint8_t*>(texels.data()), count * sizeof(uint32_t));
+        return texels;
+    };
+    const auto readCompressed = [&](const nlohmann::json& node, const uint32_t width, const uint32_t height,
+                                    const uint32_t faces) {
+        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+        const auto format = magic_enum::enum_cast<BlockFormat>(node.at("blockFormat").get<std::string>()).value();
+        CompressedImage image{ format, width, height, faces,
+                               std::vector<uint8_t>(getCompressedSize(format, width, height, faces)) };
+        readData(node, image.data.data(), image.data.size());
+        return image;
+    };
+    const auto readVoxels = [&](const nlohmann::json& node, const size_t count) {
+        std::vector<uint8_t> voxels(count);
+        readData(node, voxels.data(), count);
+        return voxels;
+    };
+
+    json.at("metadata").get_to(sttf.metadata);
+    std::unordered_map<std::string, Node*> nodeMap;
+    for(auto& node : json.at("nodes")) {
+        std::unique_ptr<Node> nodeVal;
+        // NOLINTNEXTLINE(clang-diagnostic-switch-enum)
+        switch(magic_enum::enum_cast<NodeClass>(node.at("class").get<std::string>()).value_or(NodeClass::Unknown)) {
+            case NodeClass::RenderOutput: {
+                nodeVal = std::make_unique<RenderOutput>();
+                break;
+            }
+            case NodeClass::GLSLShader: {
+                auto shader =
+                    std::make_unique<GLSLShader>(node.at("source").get<std::string>(),
+                                                 // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+                                                 magic_enum::enum_cast<NodeType>(node.at("type").get<std::string>()).value());
+                if(node.contains("format"))
+                    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+                    shader->format = magic_enum::enum_cast<Format>(node.at("format").get<std::string>()).value();
+                if(node.contains("faceSize")) {
+                    shader->faceSize = node.at("faceSize").get<uint32_t>();
+                    if(shader->faceSize == 0) {
+                        Log(HelloImGui::LogLevel::Error, "Invalid face size of cube map %s",
+                            node.at("name").get<std::string>().c_str());
+                        throw Error{};
+                    }
                 }
+                nodeVal = std::move(shader);
+                break;
+            }
+            case NodeClass::Texture: {
+                const auto width = node.at("width").get<uint32_t>();
+                const auto height = node.at("height").get<uint32_t>();
+                if(node.contains("blockFormat")) {
+                    auto texture = std::make_unique<Texture>(width, height, std::vector<uint32_t>{});
+                    texture->compressed = readCompressed(node, width, height, 1);
+                    nodeVal = std::move(texture);
+                } else
+                    nodeVal = std::make_unique<Texture>(width, height, readTexels(node, static_cast<size_t>(width) * height));
+                break;
+            }
+            case NodeClass::CubeMap: {
+                const auto size = node.at("size").get<uint32_t>();
+                if(node.contains("blockFormat")) {
+                    auto texture = std::make_unique<CubeMap>(size, std::vector<uint32_t>{});
+                    texture->compressed = readCompressed(node, size, size, 6);
+                    nodeVal = std::move(texture);
+                } else
+                    nodeVal = std::make_unique<CubeMap>(size, readTexels(node, static_cast<size_t>(size) * size * 6));
+                break;
+            }
+            case NodeClass::Volume: {
+                const auto size = node.at("size").get<uint32_t>();
+                const auto channels = node.at("channels").get<uint32_t>();
+                nodeVal = std::make_unique<Volume>(size, channels,
+                                                   readVoxels(node, static_cast<size_t>(size) * size * size * channels));
+                break;
+            }
+            case NodeClass::LastFrame: {
+                nodeVal =
+                    std::make_unique<LastFrame>(node.at("ref").get<std::string>(),
+                                                // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+                                                magic_enum::enum_cast<NodeType>(node.at("type").get<std::string>()).value());
+                break;
+            }
+            case NodeClass::Keyboard: {
+                nodeVal = std::make_unique<Keyboard>();
+                break;
+            }
+            default: {
+                Log(HelloImGui::LogLevel::Error, "Unknown node class %s", node.at("class").get<std::string>().c_str());
+                throw Error{};
             }
-            nodeVal->name = node.at("name").get<std::string>();
-            nodeMap.emplace(nodeVal->name, nodeVal.get());
-            nodes.push_back(std::move(nodeVal));
         }
-        for(auto& node : nodes) {
-            if(node->getNodeClass() == NodeClass::LastFrame) {
-                auto& lastFrame = dynamic_cast<LastFrame&>(*node);
-                lastFrame.refNode = nodeMap.at(lastFrame.refNodeName);
+        nodeVal->name = node.at("name").get<std::string>();
+        nodeMap.emplace(nodeVal->name, nodeVal.get());
+        sttf.nodes.push_back(std::move(nodeVal));
+    }
+    for(auto& node : sttf.nodes) {
+        if(node->getNodeClass() == NodeClass::LastFrame) {
+            auto& lastFrame = dynamic_cast<LastFrame&>(*node);
+            lastFrame.refNode = nodeMap.at(lastFrame.refNodeName);
+        }
+    }
+    for(auto& link : json.at("links")) {
+        const auto start = link.at("start").get<std::string>();
+        const auto end = link.at("end").get<std::string>();
+        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+        const auto filter = magic_enum::enum_cast<Filter>(link.at("filter").get<std::string>()).value();
+        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+        const auto wrapMode = magic_enum::enum_cast<Wrap>(link.at("wrapMode").get<std::string>()).value();
+        const auto slot = link.at("slot").get<uint32_t>();
+        sttf.links.push_back(Link{ nodeMap.at(start), nodeMap.at(end), filter, wrapMode, slot });
+    }
+}
+
+static void parseBinary(ShaderToyTransmissionFormat& sttf, AssetDecoder& decoder) {
+    const auto data = decoder.file().data();
+    const auto size = decoder.file().size();
+    BinaryHeader header{};
+    if(size >= sizeof(header))
+        std::memcpy(&header, data, sizeof(header));
+    if(header.version != BinaryHeader::currentVersion || header.headerSize > size - sizeof(header)) {
+        Log(HelloImGui::LogLevel::Error, "Unsupported binary STTF version %u", header.version);
+        throw Error{};
+    }
+    const auto json = nlohmann::json::parse(data + sizeof(header), data + sizeof(header) + header.headerSize);
+    const auto chunkBase = alignChunk(sizeof(header) + static_cast<size_t>(header.headerSize));
+    const auto chunkData = data + std::min(chunkBase, size);
+    const auto chunkDataSize = size - std::min(chunkBase, size);
+    const auto& chunks = json.at("chunks");
+    parseGraph(sttf, json, [&](const nlohmann::json& node, uint8_t* dst, const size_t dstSize) {
+        auto name = node.at("name").get<std::string>();
+        const auto& chunk = chunks.at(node.at("chunk").get<size_t>());
+        const auto offset = chunk.at("offset").get<size_t>();
+        const auto storedSize = chunk.at("size").get<size_t>();
+        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+        const auto compression = magic_enum::enum_cast<ChunkCompression>(chunk.at("compression").get<std::string>()).value();
+        if(chunk.at("rawSize").get<size_t>() != dstSize || offset > chunkDataSize || storedSize > chunkDataSize - offset ||
+           (compression == ChunkCompression::None && storedSize != dstSize)) {
+            Log(HelloImGui::LogLevel::Error, "Corrupted data of node %s", name.c_str());
+            throw Error{};
+        }
+        const auto src = chunkData + offset;
+        decoder.addTask(dstSize, [=, name = std::move(name)]() -> std::optional<std::string> {
+            if(compression == ChunkCompression::None) {
+                std::memcpy(dst, src, dstSize);
+                return std::nullopt;
             }
+            const auto ret = ZSTD_decompress(dst, dstSize, src, storedSize);
+            if(ZSTD_isError(ret) || ret != dstSize)
+                return "Failed to decompress data of node " + name + ": " +
+                    (ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "size mismatch");
+            return std::nullopt;
+        });
+    });
+}
+
+// Builds the same DOM as nlohmann::json::parse, except that the base64 "data" string of each node is moved out of the lexer
+// and replaced by its index. The DOM never holds the texture data, which is decoded later by the AssetDecoder.
+class TextSaxParser final : public nlohmann::json::json_sax_t {
+    nlohmann::json& mRoot;
+    std::vector<std::string>& mEncoded;
+    std::vector<nlohmann::json*> mStack;
+    nlohmann::json* mElement = nullptr;  // value slot of the last key
+    bool mDataKey = false;
+
+    static constexpr size_t nodeDepth = 3;  // root, "nodes", node
+
+    template <typename Value>
+    nlohmann::json* handleValue(Value&& value) {
+        mDataKey = false;
+        if(mStack.empty()) {
+            mRoot = nlohmann::json(std::forward<Value>(value));
+            return &mRoot;
         }
-        for(auto link : json.at("links")) {
-            const auto start = link.at("start").get<std::string>();
-            const auto end = link.at("end").get<std::string>();
-            // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-            const auto filter = magic_enum::enum_cast<Filter>(link.at("filter").get<std::string>()).value();
-            // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-            const auto wrapMode = magic_enum::enum_cast<Wrap>(link.at("wrapMode").get<std::string>()).value();
-            const auto slot = link.at("slot").get<uint32_t>();
-            links.push_back(Link{ nodeMap.at(start), nodeMap.at(end), filter, wrapMode, slot });
+        auto& top = *mStack.back();
+        if(top.is_array()) {
+            top.emplace_back(std::forward<Value>(value));
+            return &top.back();
         }
+        *mElement = nlohmann::json(std::forward<Value>(value));
+        return mElement;
+    }
+
+public:
+    TextSaxParser(nlohmann::json& root, std::vector<std::string>& encoded) : mRoot{ root }, mEncoded{ encoded } {}
+    bool null() override {
+        handleValue(nullptr);
+        return true;
+    }
+    bool boolean(const bool val) override {
+        handleValue(val);
+        return true;
+    }
+    bool number_integer(const number_integer_t val) override {
+        handleValue(val);
+        return true;
+    }
+    bool number_unsigned(const number_unsigned_t val) override {
+        handleValue(val);
+        return true;
+    }
+    bool number_float(const number_float_t val, const string_t&) override {
+        handleValue(val);
+        return true;
+    }
+    bool string(string_t& val) override {
+        if(mDataKey) {
+            mEncoded.push_back(std::move(val));  // the lexer clears its buffer before the next token
+            handleValue(mEncoded.size() - 1);
+            return true;
+        }
+        handleValue(val);
+        return true;
+    }
+    bool binary(binary_t& val) override {
+        handleValue(std::move(val));
+        return true;
+    }
+    bool start_object(std::size_t) override {
+        mStack.push_back(handleValue(nlohmann::json::value_t::object));
+        return true;
+    }
+    bool key(string_t& val) override {
+        mElement = &(*mStack.back())[val];
+        mDataKey = mStack.size() == nodeDepth && val == "data";
+        return true;
+    }
+    bool end_object() override {
+        mStack.pop_back();
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        mStack.push_back(handleValue(nlohmann::json::value_t::array));
+        return true;
+    }
+    bool end_array() override {
+        mStack.pop_back();
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::json::exception& ex) override {
+        throw ex;  // NOLINT(cert-err09-cpp,cert-err61-cpp)
+    }
+};
+
+static void parseText(ShaderToyTransmissionFormat& sttf, AssetDecoder& decoder) {
+    const auto data = decoder.file().data();
+    nlohmann::json json;
+    TextSaxParser parser{ json, decoder.encoded() };
+    nlohmann::json::sax_parse(data, data + decoder.file().size(), &parser);
+
+    parseGraph(sttf, json, [&](const nlohmann::json& node, uint8_t* dst, const size_t dstSize) {
+        auto name = node.at("name").get<std::string>();
+        auto& encoded = decoder.encoded().at(node.at("data").get<size_t>());
+        const auto size = base64DecodedSize(encoded);
+        if(!size || *size < dstSize) {
+            Log(HelloImGui::LogLevel::Error, size ? "Truncated data of node %s" : "Invalid base64 data of node %s", name.c_str());
+            throw Error{};
+        }
+        decoder.addTask(dstSize, [&encoded, dst, dstSize, size = *size, name = std::move(name)]() -> std::optional<std::string> {
+            bool success;
+            if(size == dstSize) {
+                success = base64Decode(encoded, dst);
+            } else {
+                std::vector<uint8_t> buffer(size);
+                success = base64Decode(encoded, buffer.data());
+                std::memcpy(dst, buffer.data(), dstSize);
+            }
+            std::string{}.swap(encoded);
+            if(!success)
+                return "Invalid base64 data of node " + name;
+            return std::nullopt;
+        });
+    });
+}
+
+void ShaderToyTransmissionFormat::load(const std::string& filePath) {
+    loadAsync(filePath);
+    wait();
+}
+
+void ShaderToyTransmissionFormat::loadAsync(const std::string& filePath) {
+    const auto decoder = std::make_shared<AssetDecoder>(std::make_unique<MappedFile>(filePath));
+    try {
+        const auto data = decoder->file().data();
+        uint32_t magic = 0;
+        if(decoder->file().size() >= sizeof(magic))
+            std::memcpy(&magic, data, sizeof(magic));
+        if(magic == BinaryHeader::magicValue)
+            parseBinary(*this, *decoder);
+        else
+            parseText(*this, *decoder);
     } catch(const std::exception& ex) {
         Log(HelloImGui::LogLevel::Error, "Failed to parse STTF file: %s", ex.what());
         throw Error{};
     }
+    decoder->start();
+    mDecoder = decoder;
 }
-void ShaderToyTransmissionFormat::save(const std::string& filePath) const {
-    std::ofstream file{ filePath };
-    if(!file) {
-        Log(HelloImGui::LogLevel::Error, "Cannot open file %s", filePath.c_str());
-        throw Error{};
-    }
 
-    try {
-        nlohmann::json json;
-        nlohmann::to_json(json["metadata"], metadata);
-        auto& jsonNodes = json["nodes"];
-        for(auto& node : nodes) {
-            nlohmann::json jsonNode;
-            jsonNode["class"] = magic_enum::enum_name(node->getNodeClass());
-            jsonNode["name"] = node->name;
-
-            switch(node->getNodeClass()) {     // NOLINT(clang-diagnostic-switch-enum)
-                case NodeClass::RenderOutput:  // NOLINT(bugprone-branch-clone)
-                    [[fallthrough]];
-                case NodeClass::Keyboard:
-                    [[fallthrough]];
-                case NodeClass::SoundOutput: {
-                    break;
-                }
-                case NodeClass::GLSLShader: {
-                    const auto& shader = dynamic_cast<GLSLShader&>(*node);
-                    jsonNode["source"] = shader.source;
-                    jsonNode["type"] = magic_enum::enum_name(shader.nodeType);
-                    break;
-                }
-                case NodeClass::Texture: {
-                    const auto& texture = dynamic_cast<Texture&>(*node);
+bool ShaderToyTransmissionFormat::poll() {
+    if(mDecoder && !mDecoder->isFinished())
+        return false;
+    wait();
+    return true;
+}
+
+void ShaderToyTransmissionFormat::wait() {
+    if(const auto decoder = std::move(mDecoder))
+        decoder->finish();
+}
+
+float ShaderToyTransmissionFormat::getLoadProgress() const {
+    return mDecoder ? mDecoder->getProgress() : 1.0f;
+}
+
+static nlohmann::json serializeGraph(const ShaderToyTransmissionFormat& sttf, const WriteData& writeData) {
+    nlohmann::json json;
+    nlohmann::to_json(json["metadata"], sttf.metadata);
+    auto& jsonNodes = json["nodes"];
+    for(auto& node : sttf.nodes) {
+        nlohmann::json jsonNode;
+        jsonNode["class"] = magic_enum::enum_name(node->getNodeClass());
+        jsonNode["name"] = node->name;
+
+        switch(node->getNodeClass()) {     // NOLINT(clang-diagnostic-switch-enum)
+            case NodeClass::RenderOutput:  // NOLINT(bugprone-branch-clone)
+                [[fallthrough]];
+            case NodeClass::Keyboard:
+                [[fallthrough]];
+            case NodeClass::SoundOutput: {
+                break;
+            }
+            case NodeClass::GLSLShader: {
+                const auto& shader = dynamic_cast<GLSLShader&>(*node);
+                jsonNode["source"] = shader.source;
+                jsonNode["type"] = magic_enum::enum_name(shader.nodeType);
+                jsonNode["format"] = magic_enum::enum_name(shader.format);
+                if(shader.nodeType == NodeType::CubeMap)
+                    jsonNode["faceSize"] = shader.faceSize;
+                break;
+            }
+            case NodeClass::Texture: {
+                const auto& texture = dynamic_cast<Texture&>(*node);
+                if(texture.compressed) {
+                    writeData(jsonNode, texture.compressed->data.data(), texture.compressed->data.size());
+                    jsonNode["blockFormat"] = magic_enum::enum_name(texture.compressed->format);
+                } else {
                     const auto bytes = gsl::as_bytes(gsl::span<const uint32_t>{ texture.pixel.data(), texture.pixel.size() });
-                    jsonNode["data"] = base64_encode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
-                    jsonNode["width"] = texture.width;
-                    jsonNode["height"] = texture.height;
-                    break;
+                    writeData(jsonNode, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
                 }
-                case NodeClass::CubeMap: {
-                    const auto& texture = dynamic_cast<CubeMap&>(*node);
+                jsonNode["width"] = texture.width;
+                jsonNode["height"] = texture.height;
+                break;
+            }
+            case NodeClass::CubeMap: {
+                const auto& texture = dynamic_cast<CubeMap&>(*node);
+                if(texture.compressed) {
+                    writeData(jsonNode, texture.compressed->data.data(), texture.compressed->data.size());
+                    jsonNode["blockFormat"] = magic_enum::enum_name(texture.compressed->format);
+                } else {
                     const auto bytes = gsl::as_bytes(gsl::span<const uint32_t>{ texture.pixel.data(), texture.pixel.size() });
-                    jsonNode["data"] = base64_encode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
-                    jsonNode["size"] = texture.size;
-                    break;
-                }
-                case NodeClass::Volume: {
-                    const auto& texture = dynamic_cast<Volume&>(*node);
-                    const auto bytes = gsl::as_bytes(gsl::span<const uint8_t>{ texture.pixel.data(), texture.pixel.size() });
-                    jsonNode["data"] = base64_encode(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
-                    jsonNode["size"] = texture.size;
-                    jsonNode["channels"] = texture.channels;
-                    break;
-                }
-                case NodeClass::LastFrame: {
-                    auto& lastFrame = dynamic_cast<LastFrame&>(*node);
-                    jsonNode["ref"] = lastFrame.refNodeName;
-                    jsonNode["type"] = magic_enum::enum_name(lastFrame.nodeType);
-                    break;
-                }
-                default: {
-                    reportNotImplemented();
+                    writeData(jsonNode, reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
                 }
+                jsonNode["size"] = texture.size;
+                break;
+            }
+            case NodeClass::Volume: {
+                const auto& texture = dynamic_cast<Volume&>(*node);
+                writeData(jsonNode, texture.pixel.data(), texture.pixel.size());
+                jsonNode["size"] = texture.size;
+                jsonNode["channels"] = texture.channels;
+                break;
+            }
+            case NodeClass::LastFrame: {
+                auto& lastFrame = dynamic_cast<LastFrame&>(*node);
+                jsonNode["ref"] = lastFrame.refNodeName;
+                jsonNode["type"] = magic_enum::enum_name(lastFrame.nodeType);
+                break;
+            }
+            default: {
+                reportNotImplemented();
             }
-            jsonNodes.push_back(jsonNode);
         }
+        jsonNodes.push_back(jsonNode);
+    }
 
-        auto& jsonLinks = json["links"];
-        for(const auto& [start, end, filter, wrapMode, slot] : links) {
-            nlohmann::json jsonLink;
-            jsonLink["start"] = start->name;
-            jsonLink["end"] = end->name;
-            jsonLink["filter"] = magic_enum::enum_name(filter);
-            jsonLink["wrapMode"] = magic_enum::enum_name(wrapMode);
-            jsonLink["slot"] = slot;
-            jsonLinks.push_back(jsonLink);
+    auto& jsonLinks = json["links"];
+    for(const auto& [start, end, filter, wrapMode, slot] : sttf.links) {
+        nlohmann::json jsonLink;
+        jsonLink["start"] = start->name;
+        jsonLink["end"] = end->name;
+        jsonLink["filter"] = magic_enum::enum_name(filter);
+        jsonLink["wrapMode"] = magic_enum::enum_name(wrapMode);
+        jsonLink["slot"] = slot;
+        jsonLinks.push_back(jsonLink);
+    }
+    return json;
+}
+
+// Identical blobs (e.g. a texture used by several shaders) are stored once. Chunks are compressed with zstd unless that does
+// not make them smaller.
+static void saveBinary(const ShaderToyTransmissionFormat& sttf, std::ofstream& file) {
+    struct Chunk final {
+        const uint8_t* data;
+        size_t size;
+        std::vector<uint8_t> compressed;  // empty if stored as is
+    };
+    std::vector<Chunk> chunks;
+    std::unordered_multimap<uint64_t, size_t> chunkMap;
+    auto json = serializeGraph(sttf, [&](nlohmann::json& node, const uint8_t* data, const size_t size) {
+        const auto hash = hashString(std::string_view{ reinterpret_cast<const char*>(data), size });
+        const auto [begin, end] = chunkMap.equal_range(hash);
+        const auto iter = std::find_if(begin, end, [&](const auto& entry) {
+            const auto& chunk = chunks[entry.second];
+            return chunk.size == size && std::memcmp(chunk.data, data, size) == 0;
+        });
+        if(iter != end) {
+            node["chunk"] = iter->second;
+            return;
         }
+        node["chunk"] = chunks.size();
+        chunkMap.emplace(hash, chunks.size());
+        chunks.push_back(Chunk{ data, size, {} });
+    });
 
-        file << json;
+    auto& jsonChunks = json["chunks"];
+    jsonChunks = nlohmann::json::array();
+    size_t offset = 0;
+    for(auto& chunk : chunks) {
+        std::vector<uint8_t> compressed(ZSTD_compressBound(chunk.size));
+        const auto ret = ZSTD_compress(compressed.data(), compressed.size(), chunk.data, chunk.size, compressionLevel);
+        if(!ZSTD_isError(ret) && ret < chunk.size) {
+            compressed.resize(ret);
+            chunk.compressed = std::move(compressed);
+        }
+        const auto storedSize = chunk.compressed.empty() ? chunk.size : chunk.compressed.size();
+        nlohmann::json jsonChunk;
+        jsonChunk["offset"] = offset;
+        jsonChunk["size"] = storedSize;
+        jsonChunk["rawSize"] = chunk.size;
+        jsonChunk["compression"] =
+            magic_enum::enum_name(chunk.compressed.empty() ? ChunkCompression::None : ChunkCompression::Zstd);
+        jsonChunks.push_back(jsonChunk);
+        offset = alignChunk(offset + storedSize);
+    }
+
+    const auto headerText = json.dump();
+    const BinaryHeader header{ BinaryHeader::magicValue, BinaryHeader::currentVersion, headerText.size() };
+    const char padding[chunkAlignment]{};
+    const auto pad = [&](const size_t size) {
+        file.write(padding, static_cast<std::streamsize>(alignChunk(size) - size));
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(headerText.data(), static_cast<std::streamsize>(headerText.size()));
+    pad(sizeof(header) + headerText.size());
+    for(auto& chunk : chunks) {
+        const auto data = chunk.compressed.empty() ? chunk.data : chunk.compressed.data();
+        const auto size = chunk.compressed.empty() ? chunk.size : chunk.compressed.size();
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        pad(size);
+    }
+}
+
+void ShaderToyTransmissionFormat::save(const std::string& filePath) const {
+    const auto binary = isBinarySTTF(filePath);
+    std::ofstream file{ filePath, binary ? std::ios::binary | std::ios::out : std::ios::out };
+    if(!file) {
+        Log(HelloImGui::LogLevel::Error, "Cannot open file %s", filePath.c_str());
+        throw Error{};
+    }
+
+    try {
+        if(binary)
+            saveBinary(*this, file);
+        else
+            file << serializeGraph(*this, [](nlohmann::json& node, const uint8_t* data, const size_t size) {
+                node["data"] = base64_encode(data, size);
+            });
         file.close();
     } catch(const std::exception& ex) {
         Log(HelloImGui::LogLevel::Error, "Failed to write STTF file: %s", ex.what());
         throw Error{};
     }
+    if(!file) {
+        Log(HelloImGui::LogLevel::Error, "Failed to write file %s", filePath.c_str());
+        throw Error{};
+    }
 }
 
 SHADERTOY_NAMESPACE_END
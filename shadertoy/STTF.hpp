@@ -14,8 +14,10 @@
 
 #pragma once
 
+#include "shadertoy/BlockCompression.hpp"
 #include "shadertoy/Config.hpp"
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -26,6 +28,7 @@ enum class NodeClass { RenderOutput, SoundOutput, GLSLShader, Texture, CubeMap,
 enum class NodeType { Image, CubeMap, Volume, Sound };
 enum class Filter { Mipmap, Linear, Nearest };
 enum class Wrap { Clamp, Repeat };
+enum class Format { Auto, RGBA32F, RGBA16F, RGBA8, R11G11B10F };  // of render targets
 
 struct Node {
     std::string name;
@@ -62,8 +65,12 @@ public:
 */
 
 struct GLSLShader final : Node {
+    static constexpr uint32_t defaultFaceSize = 1024;
+
     std::string source;
     NodeType nodeType;
+    Format format = Format::RGBA32F;  // also the format of files without one
+    uint32_t faceSize = defaultFaceSize;  // CubeMap only
 
     GLSLShader(std::string src, const NodeType type) : source{ std::move(src) }, nodeType{ type } {}
     [[nodiscard]] NodeClass getNodeClass() const noexcept override {
@@ -92,7 +99,8 @@ struct LastFrame final : Node {
 struct Texture final : Node {
     uint32_t width;
     uint32_t height;
-    std::vector<uint32_t> pixel;  // R8G8B8A8
+    std::vector<uint32_t> pixel;              // R8G8B8A8
+    std::optional<CompressedImage> compressed;  // replaces pixel if present
 
     Texture(const uint32_t w, const uint32_t h, std::vector<uint32_t> data) : width{ w }, height{ h }, pixel{ std::move(data) } {}
     [[nodiscard]] NodeClass getNodeClass() const noexcept override {
@@ -105,7 +113,8 @@ struct Texture final : Node {
 
 struct CubeMap final : Node {
     uint32_t size;
-    std::vector<uint32_t> pixel;  // R8G8B8A8 * 6
+    std::vector<uint32_t> pixel;              // R8G8B8A8 * 6
+    std::optional<CompressedImage> compressed;  // replaces pixel if present
 
     CubeMap(const uint32_t x, std::vector<uint32_t> data) : size{ x }, pixel{ std::move(data) } {}
     [[nodiscard]] NodeClass getNodeClass() const noexcept override {
@@ -148,14 +157,29 @@ struct Link final {
     uint32_t slot;
 };
 
+class AssetDecoder;
+
 struct ShaderToyTransmissionFormat final {
     using Metadata = std::unordered_map<std::string, std::string>;
     Metadata metadata;
     std::vector<std::unique_ptr<Node>> nodes;
     std::vector<Link> links;
 
+    // Both formats are detected by content. The text format is a JSON document with base64 texture data. The binary format
+    // (.sttfb) stores the same graph followed by aligned, deduplicated and optionally zstd compressed chunks, and is mapped
+    // into memory for loading. Textures and cube maps store either R8G8B8A8 pixels or block-compressed mip chains.
     void load(const std::string& filePath);
+    // Parses the graph, then decodes the texture data of all asset nodes concurrently on worker threads. The pixels of the
+    // nodes must not be accessed before poll() returned true or wait() returned. Both throw Error if decoding failed.
+    void loadAsync(const std::string& filePath);
+    [[nodiscard]] bool poll();
+    void wait();
+    [[nodiscard]] float getLoadProgress() const;
+    // writes the binary format if filePath ends with .sttfb
     void save(const std::string& filePath) const;
+
+private:
+    std::shared_ptr<AssetDecoder> mDecoder;  // destroyed first, cancels the decoding of the remaining assets
 };
 
 SHADERTOY_NAMESPACE_END
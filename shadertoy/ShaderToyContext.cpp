@@ -14,12 +14,16 @@
 
 #define IMGUI_DEFINE_MATH_OPERATORS
 #include "shadertoy/ShaderToyContext.hpp"
+#include "shadertoy/PipelineBuilder.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
 #include <ctime>
 
 #include "shadertoy/SuppressWarningPush.hpp"
 
+#include <hello_imgui/hello_imgui.h>
 #include <imgui.h>
 
 #include "shadertoy/SuppressWarningPop.hpp"
@@ -90,7 +94,21 @@ void ShaderToyContext::render(const ImVec2 base, const ImVec2 size, const std::o
         mMouse.w = -std::fabs(mMouse.w);
     }
 
+    pollScreenshots();
+    if(mExport) {
+        updateExport();
+        if(mExport) {
+            const auto progress = getExportProgress();
+            drawList->AddRect(mBase, mBase + mSize, IM_COL32(255, 255, 255, 255));
+            drawList->AddRectFilled(mBase, mBase + ImVec2{ mSize.x * progress, mSize.y }, IM_COL32(64, 64, 64, 255));
+            char text[64];
+            std::snprintf(text, sizeof(text), "Exporting %u/%u", mExport->written, mExport->frames);
+            drawList->AddText(mBase + (mSize - ImGui::CalcTextSize(text)) * 0.5f, IM_COL32(255, 255, 255, 255), text);
+            return;
+        }
+    }
     if(mPipeline) {
+        updateResolutionScale();
         drawList->AddCallback(
             [](const ImDrawList*, const ImDrawCmd* cmd) {
                 const auto drawData = ImGui::GetDrawData();
@@ -104,18 +122,141 @@ void ShaderToyContext::render(const ImVec2 base, const ImVec2 size, const std::o
                 if(clipMax.x <= clipMin.x || clipMax.y <= clipMin.y)
                     return;
                 ctx->mBound = { clipMin.x, clipMin.y, clipMax.x, clipMax.y };
-                ctx->mPipeline->render(
-                    fbSize, clipMin, clipMax, ctx->mSize,
-                    { ctx->mTime, ctx->mTimeDelta, ctx->mFrameRate, ctx->mFrameCount, ctx->mMouse, ctx->mDate });
+                const ShaderToyUniform uniform{ ctx->mTime,       ctx->mTimeDelta, ctx->mFrameRate,
+                                                ctx->mFrameCount, ctx->mMouse,     ctx->mDate };
+                // at most one capture per frame, so that the canvas is rendered exactly once
+                const auto iter = std::find_if(ctx->mScreenshots.begin(), ctx->mScreenshots.end(),
+                                               [](const Screenshot& screenshot) { return !screenshot.readback; });
+                if(iter == ctx->mScreenshots.end()) {
+                    ctx->mPipeline->render(fbSize, clipMin, clipMax, ctx->mSize, uniform);
+                    return;
+                }
+                if(iter->size.x <= 0.0f || iter->size.y <= 0.0f)
+                    iter->size = clipMax - clipMin;
+                iter->readback = ctx->mPipeline->capture(fbSize, clipMin, clipMax, ctx->mSize, uniform, iter->size);
             },
             this);
         drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
     } else
         drawList->AddRect(mBase, ImVec2{ mBase.x + mSize.x, mBase.y + mSize.y }, IM_COL32(255, 255, 0, 255));
 }
-void ShaderToyContext::reset(std::unique_ptr<Pipeline> pipeline) {
+void ShaderToyContext::captureScreenshot(const uint32_t width, const uint32_t height, ScreenshotCallback callback) {
+    const ImVec2 size = width && height ? ImVec2{ static_cast<float>(width), static_cast<float>(height) } : ImVec2{ 0.0f, 0.0f };
+    mScreenshots.push_back(Screenshot{ size, std::move(callback), nullptr });
+}
+void ShaderToyContext::pollScreenshots() {
+    for(auto iter = mScreenshots.begin(); iter != mScreenshots.end();) {
+        if(!iter->readback) {
+            ++iter;
+            continue;
+        }
+        auto pixels = iter->readback->poll();
+        if(!pixels) {
+            ++iter;
+            continue;
+        }
+        iter->callback(static_cast<uint32_t>(iter->size.x), static_cast<uint32_t>(iter->size.y), std::move(*pixels));
+        iter = mScreenshots.erase(iter);
+    }
+}
+void ShaderToyContext::startExport(std::unique_ptr<VideoWriter> writer, const uint32_t frames) {
+    if(!mPipeline || !frames)
+        return;
+    mPipeline->clearFrameBuffers();
+    mResolutionScale = mSmoothedScale = 1.0f;
+    mPipeline->setResolutionScale(mResolutionScale);
+
+    constexpr uint32_t readbackDepth = 4;
+    auto job = std::make_unique<Export>();
+    job->target = createRenderTarget(writer->width(), writer->height());
+    job->ring = createReadbackRing(writer->width(), writer->height(), readbackDepth);
+    job->writer = std::move(writer);
+    job->frames = frames;
+    mExport = std::move(job);
+}
+void ShaderToyContext::stopExport(const bool aborted) {
+    if(!mExport)
+        return;
+    auto& job = *mExport;
+    while(!job.ring->empty()) {
+        if(job.frame.empty())
+            job.frame = job.writer->acquireFrame();
+        job.ring->pop(job.frame.data(), true);
+        job.writer->submitFrame(std::move(job.frame));
+        job.frame.clear();
+        ++job.written;
+    }
+    if(!job.writer->finish())
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to export the video");
+    else if(aborted)
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Export aborted by a pipeline change after %u of %u frames", job.written,
+                        job.frames);
+    else
+        HelloImGui::Log(HelloImGui::LogLevel::Info, "Exported %u frames", job.written);
+    mExport.reset();
+    // the feedback buffers hold the last exported frame
+    reset();
+}
+// Keeps a few frames in flight so that neither the GPU nor the writer thread waits for the other. Each UI frame spends a fixed
+// budget on rendering, so the application stays responsive.
+void ShaderToyContext::updateExport() {
+    constexpr auto budget = std::chrono::milliseconds{ 30 };
+    auto& job = *mExport;
+    const auto deadline = Clock::now() + budget;
+    const auto fps = job.writer->frameRate();
+    const ImVec2 size{ static_cast<float>(job.writer->width()), static_cast<float>(job.writer->height()) };
+    const auto popFrame = [&](const bool wait) {
+        if(job.frame.empty())
+            job.frame = job.writer->acquireFrame();
+        if(!job.ring->pop(job.frame.data(), wait))
+            return false;
+        job.writer->submitFrame(std::move(job.frame));
+        job.frame.clear();
+        ++job.written;
+        return true;
+    };
+    while(job.rendered < job.frames && Clock::now() < deadline) {
+        if(job.ring->full())
+            popFrame(true);
+        job.target->bind();
+        mPipeline->render(size, ImVec2{ 0.0f, 0.0f }, size, size, offlineUniform(static_cast<int32_t>(job.rendered), fps, 0.0f));
+        job.target->unbind();
+        job.ring->push(*job.target);
+        ++job.rendered;
+    }
+    while(popFrame(false)) {
+    }
+    if(job.written == job.frames)
+        stopExport();
+}
+void ShaderToyContext::reset(std::unique_ptr<Pipeline> pipeline, const bool keepTime) {
+    stopExport(true);
+    if(mPipeline && pipeline)
+        pipeline->takeOver(*mPipeline);
     mPipeline = std::move(pipeline);
+    if(keepTime)
+        return;
+    mResolutionScale = mSmoothedScale = 1.0f;
     reset();
 }
+// Steers the internal resolution toward the GPU time budget of the target frame rate. The cost of a pass scales with the
+// pixel count, i.e. the square of the scale. Measurements lag a few frames behind, so the scale moves gradually and in
+// steps of 1/20 with some hysteresis to avoid reallocating the frame buffers every frame.
+void ShaderToyContext::updateResolutionScale() {
+    constexpr float minScale = 0.25f;
+    constexpr float headroom = 0.85f;  // ImGui and the compositor also need GPU time
+    constexpr float damping = 0.1f;
+    constexpr float steps = 20.0f;
+    if(!mDynamicResolution)
+        mResolutionScale = mSmoothedScale = 1.0f;
+    else if(const auto gpuTime = mPipeline->getGPUFrameTime(); gpuTime > 0.0f) {
+        const auto budget = 1000.0f / std::max(mTargetFrameRate, 1.0f) * headroom;
+        const auto ideal = std::clamp(mResolutionScale * std::sqrt(budget / gpuTime), minScale, 1.0f);
+        mSmoothedScale += (ideal - mSmoothedScale) * damping;
+        if(std::fabs(mSmoothedScale - mResolutionScale) * steps > 0.75f)
+            mResolutionScale = std::clamp(std::round(mSmoothedScale * steps) / steps, minScale, 1.0f);
+    }
+    mPipeline->setResolutionScale(mResolutionScale);
+}
 
 SHADERTOY_NAMESPACE_END
@@ -16,10 +16,31 @@
 #include "shadertoy/Backend.hpp"
 #include "shadertoy/Config.hpp"
 #include "shadertoy/Support.hpp"
+#include "shadertoy/VideoWriter.hpp"
+#include <functional>
+#include <vector>
 
 SHADERTOY_NAMESPACE_BEGIN
 
+// R8G8B8A8 pixels with the bottom row first
+using ScreenshotCallback = std::function<void(uint32_t width, uint32_t height, std::vector<uint32_t> pixels)>;
+
 class ShaderToyContext final {
+    struct Screenshot final {
+        ImVec2 size;  // in pixels, zero for the canvas size
+        ScreenshotCallback callback;
+        std::unique_ptr<PixelReadback> readback;  // set once rendered
+    };
+    struct Export final {
+        std::unique_ptr<VideoWriter> writer;
+        std::unique_ptr<RenderTarget> target;
+        std::unique_ptr<ReadbackRing> ring;
+        std::vector<uint32_t> frame;  // acquired from writer, empty if not yet
+        uint32_t frames;
+        uint32_t rendered = 0;
+        uint32_t written = 0;
+    };
+
     using SystemClock = std::chrono::system_clock;
     SystemClock::time_point mStartTime;
     SystemClock::time_point mPauseTime;
@@ -34,8 +55,18 @@ class ShaderToyContext final {
     ImVec4 mMouse{ 0.0f, 0.0f, -1.0f, -1.0f };
     ImVec4 mDate;
     ImVec4 mBound;
+    bool mDynamicResolution = false;
+    float mTargetFrameRate = 60.0f;
+    float mResolutionScale = 1.0f;  // applied to the pipeline
+    float mSmoothedScale = 1.0f;
 
     std::unique_ptr<Pipeline> mPipeline;
+    std::vector<Screenshot> mScreenshots;
+    std::unique_ptr<Export> mExport;
+
+    void updateResolutionScale();
+    void pollScreenshots();
+    void updateExport();
 
 public:
     ShaderToyContext();
@@ -55,7 +86,26 @@ public:
     void resume();
     void reset();
     void render(ImVec2 base, ImVec2 size, const std::optional<ImVec4>& mouse);
-    void reset(std::unique_ptr<Pipeline> pipeline);
+    // keepTime continues the clock, e.g. after an incremental rebuild
+    // aborts a running export, callers should wait until isExporting() is false
+    void reset(std::unique_ptr<Pipeline> pipeline, bool keepTime = false);
+    // Captures the next frame at width x height pixels, or at the canvas size if either is 0. The frame is read back without
+    // stalling, and callback is invoked from render() once the pixels are available.
+    void captureScreenshot(uint32_t width, uint32_t height, ScreenshotCallback callback);
+    // Renders frames [0, frames) at the frame rate of writer, offscreen and as fast as the UI allows. The feedback buffers are
+    // cleared first so that the output does not depend on what was shown before. The canvas is not updated meanwhile.
+    void startExport(std::unique_ptr<VideoWriter> writer, uint32_t frames);
+    // writes the frames rendered so far, an aborted export is reported as failed
+    void stopExport(bool aborted = false);
+    [[nodiscard]] bool isExporting() const noexcept {
+        return static_cast<bool>(mExport);
+    }
+    [[nodiscard]] float getExportProgress() const noexcept {
+        return mExport ? static_cast<float>(mExport->written) / static_cast<float>(mExport->frames) : 0.0f;
+    }
+    [[nodiscard]] const Pipeline* getPipeline() const noexcept {
+        return mPipeline.get();
+    }
 
     [[nodiscard]] ImVec4 getMouseStatus() const noexcept {
         return mMouse;
@@ -66,9 +116,21 @@ public:
     float& getTimeScale() noexcept {
         return mTimeScale;
     }
+    bool& getDynamicResolution() noexcept {
+        return mDynamicResolution;
+    }
+    float& getTargetFrameRate() noexcept {
+        return mTargetFrameRate;
+    }
+    [[nodiscard]] float getResolutionScale() const noexcept {
+        return mResolutionScale;
+    }
     [[nodiscard]] bool isValid() const noexcept {
         return static_cast<bool>(mPipeline);
     }
+    [[nodiscard]] std::vector<PassStatistics> getStatistics() const {
+        return mPipeline ? mPipeline->getStatistics() : std::vector<PassStatistics>{};
+    }
 };
 
 SHADERTOY_NAMESPACE_END
@@ -0,0 +1,620 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+
+#include "shadertoy/ShaderToyImporter.hpp"
+#include "shadertoy/AssetDownloader.hpp"
+#include "shadertoy/DiskCache.hpp"
+#include "shadertoy/Support.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <fmt/format.h>
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+#include <stb_image.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+static constexpr auto initialCubeMap =
+    R"(void mainCubemap( out vec4 fragColor, in vec2 fragCoord, in vec3 rayOri, in vec3 rayDir )
+{
+    // Ray direction as color
+    vec3 col = 0.5 + 0.5*rayDir;
+
+    // Output to cubemap
+    fragColor = vec4(col,1.0);
+}
+)";
+
+static constexpr auto initialBuffer = R"(void mainImage( out vec4 fragColor, in vec2 fragCoord )
+{
+    fragColor = vec4(0.0,0.0,1.0,1.0);
+}
+)";
+
+// browsers open at most six connections per host
+static constexpr size_t maxConnections = 6;
+
+// API responses, downloaded media and their decoded pixels
+static const DiskCache& getMediaCache() {
+    static const DiskCache cache{ "media", 1ULL << 30 };
+    return cache;
+}
+
+struct DecodedImage final {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixel;  // R8G8B8A8
+    bool cached = false;          // decoded pixels were loaded from the media cache
+};
+
+struct DecodedVolume final {
+    uint32_t size = 0;
+    uint32_t channels = 0;
+    std::vector<uint8_t> pixel;
+};
+
+static uint64_t getDecodedImageKey(const std::string& path, const bool flip) {
+    return hashString(path, hashString(flip ? "rgba-flipped" : "rgba"));
+}
+
+// width, height, then R8G8B8A8 pixels
+static bool loadDecodedImage(const uint64_t key, DecodedImage& image) {
+    const auto data = getMediaCache().load(key);
+    uint32_t size[2];
+    if(!data || data->size() < sizeof(size))
+        return false;
+    memcpy(size, data->data(), sizeof(size));
+    const auto pixels = static_cast<size_t>(size[0]) * size[1];
+    if(data->size() != sizeof(size) + pixels * sizeof(uint32_t))
+        return false;
+    image.width = size[0];
+    image.height = size[1];
+    image.pixel.resize(pixels);
+    memcpy(image.pixel.data(), data->data() + sizeof(size), pixels * sizeof(uint32_t));
+    return true;
+}
+
+// best effort, the image is decoded again next time
+static void storeDecodedImage(const uint64_t key, const DecodedImage& image) {
+    const uint32_t size[2] = { image.width, image.height };
+    std::vector<uint8_t> data(sizeof(size) + image.pixel.size() * sizeof(uint32_t));
+    memcpy(data.data(), size, sizeof(size));
+    memcpy(data.data() + sizeof(size), image.pixel.data(), image.pixel.size() * sizeof(uint32_t));
+    (void)getMediaCache().store(key, data.data(), data.size());
+}
+
+static std::optional<std::string> decodeImage(const std::string& body, const std::string& path, const bool flip,
+                                              DecodedImage& image) {
+    stbi_set_flip_vertically_on_load_thread(flip);
+    int width, height, channels;
+    const auto ptr = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(body.data()), static_cast<int>(body.size()), &width,
+                                           &height, &channels, 4);
+    if(!ptr)
+        return fmt::format("Failed to load texture {}: {}", path, stbi_failure_reason());
+    const auto imgGuard = scopeExit([ptr] { stbi_image_free(ptr); });
+    const auto begin = reinterpret_cast<const uint32_t*>(ptr);
+    const auto end = begin + static_cast<ptrdiff_t>(width) * height;
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixel.assign(begin, end);
+    return std::nullopt;
+}
+
+static std::optional<std::string> decodeVolume(const std::string& body, const std::string& path, DecodedVolume& volume) {
+    if(body.size() < 20ULL)
+        return fmt::format("Invalid volume format {}: {}", path, body.size());
+    uint32_t header[5];
+    memcpy(header, body.data(), sizeof(header));
+    const auto x = header[1], y = header[2], z = header[3];
+    if(x != y || y != z)
+        return fmt::format("Unsupported volume size {}: ({}, {}, {})", path, x, y, z);
+    struct Metadata final {
+        uint8_t channels;
+        uint8_t layout;
+        uint16_t format;
+    } metadata;
+    static_assert(sizeof(metadata) == sizeof(uint32_t));
+    memcpy(&metadata, &header[4], sizeof(Metadata));
+
+    if(metadata.channels != 1 && metadata.channels != 4)
+        return fmt::format("Unsupported volume channels {}: {}", path, metadata.channels);
+    if(metadata.layout != 0)
+        return fmt::format("Unsupported volume layout {}: {}", path, metadata.layout);
+    if(metadata.format != 0)
+        return fmt::format("Unsupported volume format {}: {}", path, metadata.format);
+
+    const uint32_t size = x;
+    const uint32_t channels = metadata.channels;
+    const size_t points = static_cast<size_t>(size) * size * size * channels;
+    if(body.size() != 20 + points)
+        return fmt::format("Invalid volume format {}: {}", path, body.size());
+    const auto start = reinterpret_cast<const uint8_t*>(body.data()) + 20;
+    volume.size = size;
+    volume.channels = channels;
+    volume.pixel.assign(start, start + points);
+    return std::nullopt;
+}
+
+ShaderToyImporter::ShaderToyImporter(const std::string& path, const bool offline)
+    : mHost{ getShaderToyHost() }, mOffline{ offline } {
+    std::string_view shaderId = path;
+    if(const auto pos = shaderId.find_last_of('/'); pos != std::string_view::npos)
+        shaderId = shaderId.substr(pos + 1);
+    mShaderId = shaderId;
+    mUrl = fmt::format("https://www.shadertoy.com/view/{}", mShaderId);
+    // the cache logs when it is opened, which must happen on this thread
+    mDownloader = std::make_unique<AssetDownloader>(mHost, AssetDownloader::Headers{ { "referer", mUrl } }, maxConnections,
+                                                    &getMediaCache(), offline);
+    HelloImGui::Log(HelloImGui::LogLevel::Info, "Loading from %s", mUrl.c_str());
+    mThread = std::thread{ [this] { run(); } };
+}
+
+ShaderToyImporter::~ShaderToyImporter() {
+    cancel();
+    mThread.join();
+}
+
+void ShaderToyImporter::cancel() {
+    mCancelled = true;
+    mDownloader->cancel();
+}
+
+bool ShaderToyImporter::poll() {
+    std::vector<std::pair<HelloImGui::LogLevel, std::string>> messages;
+    bool finished;
+    {
+        std::lock_guard lock{ mMutex };
+        messages.swap(mMessages);
+        finished = mFinished;
+    }
+    for(auto& [level, message] : messages)
+        HelloImGui::Log(level, "%s", message.c_str());
+    return finished;
+}
+
+std::unique_ptr<ShaderToyTransmissionFormat> ShaderToyImporter::takeResult() {
+    std::lock_guard lock{ mMutex };
+    return std::move(mResult);
+}
+
+std::vector<ShaderToyImporter::Asset> ShaderToyImporter::getAssets() const {
+    std::lock_guard lock{ mMutex };
+    return mAssets;
+}
+
+float ShaderToyImporter::getProgress() const {
+    std::lock_guard lock{ mMutex };
+    if(mAssets.empty())
+        return 0.0f;
+    const auto done = std::count_if(mAssets.cbegin(), mAssets.cend(), [](const Asset& asset) { return asset.done; });
+    return static_cast<float>(done) / static_cast<float>(mAssets.size());
+}
+
+void ShaderToyImporter::log(const HelloImGui::LogLevel level, std::string message) {
+    std::lock_guard lock{ mMutex };
+    mMessages.emplace_back(level, std::move(message));
+}
+
+void ShaderToyImporter::fail(std::string message) {
+    log(HelloImGui::LogLevel::Error, std::move(message));
+    throw Error{};
+}
+
+size_t ShaderToyImporter::addAsset(std::string path) {
+    std::lock_guard lock{ mMutex };
+    mAssets.push_back(Asset{ std::move(path), false });
+    return mAssets.size() - 1;
+}
+
+void ShaderToyImporter::markDone(const size_t index) {
+    std::lock_guard lock{ mMutex };
+    mAssets[index].done = true;
+}
+
+void ShaderToyImporter::run() {
+    std::unique_ptr<ShaderToyTransmissionFormat> result;
+    try {
+        result = import();
+    } catch(const Error&) {
+    } catch(const std::exception& e) {
+        log(HelloImGui::LogLevel::Error, fmt::format("Invalid response from shadertoy.com: {}", e.what()));
+    }
+    std::lock_guard lock{ mMutex };
+    mResult = std::move(result);
+    mFinished = true;
+}
+
+std::unique_ptr<ShaderToyTransmissionFormat> ShaderToyImporter::import() {
+    const auto& cache = getMediaCache();
+    // the shader itself may be edited, so it is only read from the cache when offline or unreachable
+    const auto apiKey = hashString(mShaderId, hashString("api"));
+    std::string body;
+    bool cachedResponse = false;
+    const auto loadCachedResponse = [&] {
+        const auto data = cache.load(apiKey);
+        if(!data)
+            fail(fmt::format("Shader {} is not cached", mShaderId));
+        body.assign(data->cbegin(), data->cend());
+        cachedResponse = true;
+    };
+    if(mOffline) {
+        loadCachedResponse();
+    } else {
+        httplib::Client client{ mHost };
+        httplib::Headers headers;
+        headers.emplace("referer", mUrl);
+        auto res = client.Post("/shadertoy", headers, R"(s={"shaders":[")" + mShaderId + "\"]}&nt=1&nl=1&np=1",
+                               "application/x-www-form-urlencoded");
+        if(!res) {
+            log(HelloImGui::LogLevel::Warning,
+                fmt::format("Cannot connect to {}: {}, using the cached response", mHost, httplib::to_string(res.error())));
+            loadCachedResponse();
+        } else {
+            if(res->status != 200)
+                fail(fmt::format("Invalid response from shadertoy.com (Status code = {}).", res->status));
+            body = std::move(res->body);
+        }
+    }
+    if(mCancelled)
+        return nullptr;
+    auto json = nlohmann::json::parse(body);
+    if(!json.is_array())
+        fail("Invalid response from shadertoy.com");
+    if(!cachedResponse)
+        (void)cache.store(apiKey, reinterpret_cast<const uint8_t*>(body.data()), body.size());
+    auto metadata = json[0].at("info");
+
+    auto sttf = std::make_unique<ShaderToyTransmissionFormat>();
+    sttf->metadata.emplace("Name", metadata.at("name").get<std::string>());
+    sttf->metadata.emplace("Author", metadata.at("username").get<std::string>());
+    sttf->metadata.emplace("Description", metadata.at("description").get<std::string>());
+    sttf->metadata.emplace("ShaderToyURL", mUrl);
+
+    auto renderPasses = json[0].at("renderpass");
+    // BA BB BC BD CA IE
+    auto getOrder = [](const std::string& name) { return std::toupper(name.front()) * 1000 + std::toupper(name.back()); };
+
+    std::unordered_set<std::string> names;
+    for(auto& pass : renderPasses)
+        names.insert(pass.at("name").get<std::string>());
+    const auto uniqueName = [&](const std::string& base) {
+        if(names.insert(base).second)
+            return base;
+        for(uint32_t idx = 1;; ++idx) {
+            if(auto str = fmt::format("{}{}", base, idx); names.insert(str).second)
+                return str;
+        }
+    };
+    const auto addNode = [&](auto node, const std::string& base) -> auto& {
+        node->name = uniqueName(base);
+        auto& ref = *node;
+        sttf->nodes.push_back(std::move(node));
+        return ref;
+    };
+
+    std::unordered_map<std::string, GLSLShader*> newShaderNodes;
+
+    auto& sinkNode = addNode(std::make_unique<RenderOutput>(), "RenderOutput");
+    auto addLink = [&](Node* src, Node* dst, uint32_t channel, nlohmann::json* ref) {
+        auto filter = Filter::Linear;
+        auto wrapMode = Wrap::Repeat;
+        if(ref) {
+            auto sampler = ref->at("sampler");
+            const auto filterName = sampler.at("filter").get<std::string>();
+            const auto wrapName = sampler.at("wrap").get<std::string>();
+            if(filterName == "linear") {
+                filter = Filter::Linear;
+            } else if(filterName == "nearest") {
+                filter = Filter::Nearest;
+            } else if(filterName == "mipmap") {
+                filter = Filter::Mipmap;
+            } else {
+                fail(fmt::format("Unsupported filter {}", filterName));
+            }
+
+            if(wrapName == "clamp") {
+                wrapMode = Wrap::Clamp;
+            } else if(wrapName == "repeat") {
+                wrapMode = Wrap::Repeat;
+            } else {
+                fail(fmt::format("Unsupported wrap mode {}", wrapName));
+            }
+        }
+        sttf->links.push_back(Link{ src, dst, filter, wrapMode, channel });
+    };
+    Keyboard* keyboard = nullptr;
+    auto getKeyboard = [&] {
+        if(!keyboard)
+            keyboard = &addNode(std::make_unique<Keyboard>(), "Keyboard");
+        return keyboard;
+    };
+    std::deque<DecodedImage> images;
+    std::deque<DecodedVolume> volumes;
+    // fill the asset nodes, once all assets are downloaded and decoded
+    std::vector<std::function<void()>> finishers;
+    // the requests refer to the locals above
+    const auto guard = scopeFail([&] {
+        mDownloader->cancel();
+        (void)mDownloader->wait();
+    });
+    const auto enqueueImage = [&](const std::string& imagePath, const bool flip) -> DecodedImage& {
+        auto& image = images.emplace_back();
+        const auto key = getDecodedImageKey(imagePath, flip);
+        const auto index = addAsset(imagePath);
+        mDownloader->enqueue(
+            imagePath,
+            [this, &image, imagePath, flip, index](const std::string& data) {
+                auto error = decodeImage(data, imagePath, flip, image);
+                if(!error)
+                    markDone(index);
+                return error;
+            },
+            [this, &image, key, index] {
+                if(!loadDecodedImage(key, image))
+                    return false;
+                image.cached = true;
+                markDone(index);
+                return true;
+            });
+        finishers.emplace_back([&image, key] {
+            if(!image.cached)
+                storeDecodedImage(key, image);
+        });
+        return image;
+    };
+    std::unordered_map<std::string, Texture*> textureCache;
+    auto getTexture = [&](nlohmann::json& tex) -> Texture* {
+        const auto id = tex.at("id").get<std::string>();
+        if(const auto iter = textureCache.find(id); iter != textureCache.cend())
+            return iter->second;
+        auto& texture = addNode(std::make_unique<Texture>(0, 0, std::vector<uint32_t>{}), "Texture");
+        const auto texPath = tex.at("filepath").get<std::string>();
+        const auto flip = tex.at("sampler").at("vflip").get<std::string>() == "true";
+        log(HelloImGui::LogLevel::Info, fmt::format("Downloading texture {}", texPath));
+        auto& image = enqueueImage(texPath, flip);
+        finishers.emplace_back([&texture, &image] {
+            texture.width = image.width;
+            texture.height = image.height;
+            texture.pixel = std::move(image.pixel);
+        });
+
+        textureCache.emplace(id, &texture);
+        return &texture;
+    };
+    std::unordered_map<std::string, CubeMap*> cubeMapCache;
+    auto getCubeMap = [&](nlohmann::json& tex) -> CubeMap* {
+        const auto id = tex.at("id").get<std::string>();
+        if(const auto iter = cubeMapCache.find(id); iter != cubeMapCache.cend())
+            return iter->second;
+        auto& texture = addNode(std::make_unique<CubeMap>(0, std::vector<uint32_t>{}), "CubeMap");
+        const auto texPath = tex.at("filepath").get<std::string>();
+        std::string base, ext;
+        if(const auto pos = texPath.find_last_of('.'); pos != std::string::npos) {
+            base = texPath.substr(0, pos);
+            ext = texPath.substr(pos);
+        } else {
+            fail(fmt::format("Failed to parse cube map {}", texPath));
+        }
+
+        const auto flip = tex.at("sampler").at("vflip").get<std::string>() == "true";
+        constexpr const char* suffixes[] = { "", "_1", "_2", "_3", "_4", "_5" };
+        std::vector<DecodedImage*> faces;
+        for(const auto suffix : suffixes) {
+            auto facePath = base;
+            facePath += suffix;
+            facePath += ext;
+            log(HelloImGui::LogLevel::Info, fmt::format("Downloading texture {}", facePath));
+            faces.push_back(&enqueueImage(facePath, flip));
+        }
+        finishers.emplace_back([this, &texture, faces, texPath] {
+            const auto size = faces.front()->width;
+            for(const auto face : faces) {
+                if(face->width != size || face->height != size)
+                    fail(fmt::format("Invalid face size of cube map {}", texPath));
+                texture.pixel.insert(texture.pixel.end(), face->pixel.cbegin(), face->pixel.cend());
+            }
+            texture.size = size;
+        });
+
+        cubeMapCache.emplace(id, &texture);
+        return &texture;
+    };
+    std::unordered_map<std::string, Volume*> volumeCache;
+    auto getVolume = [&](nlohmann::json& tex) -> Volume* {
+        const auto id = tex.at("id").get<std::string>();
+        if(const auto iter = volumeCache.find(id); iter != volumeCache.cend())
+            return iter->second;
+        auto& texture = addNode(std::make_unique<Volume>(0, 0, std::vector<uint8_t>{}), "Volume");
+        const auto texPath = tex.at("filepath").get<std::string>();
+        log(HelloImGui::LogLevel::Info, fmt::format("Downloading volume {}", texPath));
+        auto& volume = volumes.emplace_back();
+        const auto index = addAsset(texPath);
+        mDownloader->enqueue(texPath, [this, &volume, texPath, index](const std::string& data) {
+            auto error = decodeVolume(data, texPath, volume);
+            if(!error)
+                markDone(index);
+            return error;
+        });
+        finishers.emplace_back([&texture, &volume] {
+            texture.size = volume.size;
+            texture.channels = volume.channels;
+            texture.pixel = std::move(volume.pixel);
+        });
+
+        volumeCache.emplace(id, &texture);
+        return &texture;
+    };
+    // Look at any index.html at EffectPass.prototype.NewTexture if(assetID_to_cubemapBuferId)
+    const auto isDynamicCubeMap = [&](nlohmann::json& tex) {
+        const auto id = tex.at("id").get<std::string>();
+        return id == "4dX3Rr";
+    };
+    std::string common;
+    uint32_t tmpId = 0;
+    for(auto& pass : renderPasses) {
+        if(pass.at("name").get<std::string>().empty()) {
+            pass.at("name") = uniqueName(pass.at("type").get<std::string>());
+        }
+
+        if(pass.at("outputs").empty()) {
+            pass.at("outputs").push_back(nlohmann::json::object({ { "id", "tmp" + std::to_string(tmpId++) } }));
+        }
+    }
+    for(auto& pass : renderPasses) {
+        const auto type = pass.at("type").get<std::string>();
+        const auto code = pass.at("code").get<std::string>();
+        const auto name = pass.at("name").get<std::string>();
+        if(type == "common") {
+            common = code + '\n';
+        } else if(type == "image" || type == "buffer" || type == "cubemap") {
+            const auto output = pass.at("outputs")[0].at("id").get<std::string>();
+            auto nodeType = type == "cubemap" ? NodeType::CubeMap : NodeType::Image;
+
+            auto node = std::make_unique<GLSLShader>(code, nodeType);
+            node->name = name;
+            auto& shader = *node;
+            sttf->nodes.push_back(std::move(node));
+            newShaderNodes.emplace(output, &shader);
+
+            for(auto& input : pass.at("inputs")) {
+                auto inputType = input.at("type").get<std::string>();
+                if(inputType == "buffer") {
+                    continue;
+                }
+                auto channel = input.at("channel").get<uint32_t>();
+                if(inputType == "keyboard") {
+                    addLink(getKeyboard(), &shader, channel, &input);
+                } else if(inputType == "texture") {
+                    addLink(getTexture(input), &shader, channel, &input);
+                } else if(inputType == "cubemap") {
+                    if(!isDynamicCubeMap(input))
+                        addLink(getCubeMap(input), &shader, channel, &input);
+                } else if(inputType == "volume") {
+                    addLink(getVolume(input), &shader, channel, &input);
+                } else {
+                    log(HelloImGui::LogLevel::Error, fmt::format("Unsupported input type {}", inputType));
+                }
+            }
+
+            if(type == "image") {
+                addLink(&shader, &sinkNode, 0, nullptr);
+            }
+        } else {
+            log(HelloImGui::LogLevel::Error, fmt::format("Unsupported pass type {}", type));
+        }
+    }
+
+    if(!common.empty()) {
+        for(auto& [name, shader] : newShaderNodes) {
+            shader->source = common + shader->source;
+        }
+    }
+
+    std::unordered_map<GLSLShader*, LastFrame*> lastFrames;
+    auto getLastFrame = [&](GLSLShader* src) {
+        if(const auto iter = lastFrames.find(src); iter != lastFrames.cend()) {
+            return iter->second;
+        }
+        auto& lastFrame = addNode(std::make_unique<LastFrame>(src->name, src->nodeType), "LastFrame");
+        lastFrame.refNode = src;
+        lastFrames.emplace(src, &lastFrame);
+        return &lastFrame;
+    };
+    for(auto& pass : renderPasses) {
+        const auto type = pass.at("type").get<std::string>();
+        if(type == "common") {
+            continue;
+        }
+        if(type == "image" || type == "buffer" || type == "cubemap") {
+            const auto name = pass.at("name").get<std::string>();
+            const auto idxDst = getOrder(name);
+            const auto node = newShaderNodes.at(pass.at("outputs")[0].at("id").get<std::string>());
+
+            for(auto& input : pass.at("inputs")) {
+                auto inputType = input.at("type").get<std::string>();
+                bool dynamicCubeMap = inputType == "cubemap" && isDynamicCubeMap(input);
+                if(inputType != "buffer" && !dynamicCubeMap) {
+                    continue;
+                }
+
+                auto channel = input.at("channel").get<uint32_t>();
+                auto inputId = input.at("id").get<std::string>();
+
+                // There is only one dynamic cube map in Shadertoy, so we can safely use the first one
+                if(dynamicCubeMap) {
+                    for(auto& innerPass : renderPasses) {
+                        if(innerPass.at("type").get<std::string>() != "cubemap") {
+                            continue;
+                        }
+
+                        if(innerPass.at("outputs").empty())
+                            continue;
+
+                        inputId = innerPass.at("outputs")[0].at("id").get<std::string>();
+                        channel = innerPass.at("outputs")[0].at("channel").get<uint32_t>();
+                        break;
+                    }
+                }
+
+                if(!newShaderNodes.count(inputId)) {
+                    // Shadertoy doesn't fail when an input is missing, so we create a default dummy node
+                    auto& inputNode = addNode(
+                        std::make_unique<GLSLShader>(common + (inputType == "cubemap" ? initialCubeMap : initialBuffer),
+                                                     inputType != "cubemap" ? NodeType::Image : NodeType::CubeMap),
+                        inputId);
+                    newShaderNodes.emplace(inputId, &inputNode);
+                }
+
+                auto src = newShaderNodes.at(inputId);
+                const auto idxSrc = getOrder(src->name);
+                if(idxSrc < idxDst) {
+                    addLink(src, node, channel, &input);
+                } else {
+                    addLink(getLastFrame(src), node, channel, &input);
+                }
+            }
+        } else {
+            log(HelloImGui::LogLevel::Error, fmt::format("Unsupported pass type {}", type));
+        }
+    }
+
+    const auto errors = mDownloader->wait();
+    if(mCancelled)
+        return nullptr;
+    for(auto& error : errors)
+        log(HelloImGui::LogLevel::Error, error);
+    if(!errors.empty())
+        throw Error{};
+    for(auto& finisher : finishers)
+        finisher();
+    return sttf;
+}
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,93 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Config.hpp"
+#include "shadertoy/STTF.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <hello_imgui/hello_imgui.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+class AssetDownloader;
+
+// Imports a shader from shadertoy.com into a detached graph on a background thread, so that the editor and the running
+// pipeline are untouched until the import completed. Messages are queued and logged by poll() on the calling thread.
+class ShaderToyImporter final {
+public:
+    struct Asset final {
+        std::string path;
+        bool done;
+    };
+
+private:
+    std::string mShaderId;
+    std::string mUrl;
+    std::string mHost;
+    bool mOffline;
+    std::unique_ptr<AssetDownloader> mDownloader;
+    std::atomic<bool> mCancelled{ false };
+
+    mutable std::mutex mMutex;
+    std::vector<std::pair<HelloImGui::LogLevel, std::string>> mMessages;
+    std::vector<Asset> mAssets;
+    std::unique_ptr<ShaderToyTransmissionFormat> mResult;
+    bool mFinished = false;
+    std::thread mThread;
+
+    void log(HelloImGui::LogLevel level, std::string message);
+    [[noreturn]] void fail(std::string message);
+    size_t addAsset(std::string path);
+    void markDone(size_t index);
+    void run();
+    [[nodiscard]] std::unique_ptr<ShaderToyTransmissionFormat> import();
+
+public:
+    // path is a shadertoy.com URL or a shader id
+    ShaderToyImporter(const std::string& path, bool offline);
+    ShaderToyImporter(const ShaderToyImporter&) = delete;
+    ShaderToyImporter(ShaderToyImporter&&) = delete;
+    ShaderToyImporter& operator=(const ShaderToyImporter&) = delete;
+    ShaderToyImporter& operator=(ShaderToyImporter&&) = delete;
+    ~ShaderToyImporter();
+
+    // the import finishes without a result as soon as the running transfers are aborted
+    void cancel();
+    [[nodiscard]] bool isCancelled() const noexcept {
+        return mCancelled;
+    }
+    // logs the queued messages, returns true once the import finished
+    [[nodiscard]] bool poll();
+    // null if the import failed or was cancelled
+    [[nodiscard]] std::unique_ptr<ShaderToyTransmissionFormat> takeResult();
+    [[nodiscard]] std::vector<Asset> getAssets() const;
+    // fraction of the assets that are ready
+    [[nodiscard]] float getProgress() const;
+    [[nodiscard]] const std::string& getUrl() const noexcept {
+        return mUrl;
+    }
+};
+
+SHADERTOY_NAMESPACE_END
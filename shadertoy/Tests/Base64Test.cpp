@@ -0,0 +1,124 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+// Compares the vectorized decoder against a scalar reference encoder. Inputs span several SIMD blocks, so that both the
+// vectorized loop and the scalar tail are covered, as well as the rejection of invalid characters in either of them.
+
+#include "shadertoy/Base64.hpp"
+#include "shadertoy/Tests/Check.hpp"
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+static std::string encode(const std::vector<uint8_t>& data, const bool padding) {
+    constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string res;
+    for(size_t idx = 0; idx < data.size(); idx += 3) {
+        const auto count = data.size() - idx < 3 ? data.size() - idx : 3;
+        uint32_t group = 0;
+        for(size_t k = 0; k < 3; ++k)
+            group = group << 8 | (k < count ? data[idx + k] : 0U);
+        for(size_t k = 0; k <= count; ++k)
+            res.push_back(alphabet[(group >> (18 - 6 * k)) & 63]);
+        if(padding)
+            res.append(3 - count, '=');
+    }
+    return res;
+}
+
+static std::optional<std::vector<uint8_t>> decode(const std::string& src) {
+    const auto size = base64DecodedSize(src);
+    if(!size)
+        return std::nullopt;
+    // guard bytes catch writes past the decoded size
+    std::vector<uint8_t> dst(*size + 16, 0xcd);
+    if(!base64Decode(src, dst.data()))
+        return std::nullopt;
+    for(size_t idx = *size; idx < dst.size(); ++idx)
+        SHADERTOY_CHECK(dst[idx] == 0xcd);
+    dst.resize(*size);
+    return dst;
+}
+
+static void testRoundTrip() {
+    std::mt19937 gen{ 42 };  // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<uint32_t> dist{ 0, 255 };
+    for(size_t size = 0; size < 400; ++size) {
+        std::vector<uint8_t> data(size);
+        for(auto& byte : data)
+            byte = static_cast<uint8_t>(dist(gen));
+        for(const auto padding : { false, true }) {
+            const auto decoded = decode(encode(data, padding));
+            SHADERTOY_CHECK(decoded && *decoded == data);
+        }
+    }
+}
+
+static void testInvalidCharacters() {
+    std::vector<uint8_t> data(300);
+    for(size_t idx = 0; idx < data.size(); ++idx)
+        data[idx] = static_cast<uint8_t>(idx * 7);
+    const auto valid = encode(data, false);
+    SHADERTOY_CHECK(decode(valid));
+    // inside of a SIMD block, at block boundaries and in the scalar tail
+    for(size_t pos = 0; pos < valid.size(); ++pos) {
+        for(const auto ch : { '-', '_', ' ', '\n', '=', '\0', '\x80', '\xff' }) {
+            if(ch == '=' && pos + 1 == valid.size())
+                continue;  // valid padding
+            auto invalid = valid;
+            invalid[pos] = ch;
+            SHADERTOY_CHECK(!decode(invalid));
+        }
+    }
+}
+
+static void testPadding() {
+    SHADERTOY_CHECK(decode("") == std::vector<uint8_t>{});
+    SHADERTOY_CHECK(decode("QQ==") == std::vector<uint8_t>{ 'A' });
+    SHADERTOY_CHECK(decode("QUI=") == (std::vector<uint8_t>{ 'A', 'B' }));
+    SHADERTOY_CHECK(decode("QQ") == std::vector<uint8_t>{ 'A' });
+    SHADERTOY_CHECK(decode("QUI") == (std::vector<uint8_t>{ 'A', 'B' }));
+    // a single character cannot encode a whole byte
+    SHADERTOY_CHECK(!decode("Q"));
+    SHADERTOY_CHECK(!decode("QUJDQ"));
+    SHADERTOY_CHECK(!decode("Q==="));
+    SHADERTOY_CHECK(!decode("===="));
+    SHADERTOY_CHECK(!decode("QQ=A"));
+    // padding is only valid at the end of a multiple of 4 characters
+    SHADERTOY_CHECK(!decode("QQ="));
+    SHADERTOY_CHECK(!decode("QUJDQQ="));
+    SHADERTOY_CHECK(!decode("QQ==QUJD"));
+    // the same with a preceding SIMD block
+    const auto prefix = encode(std::vector<uint8_t>(96, 0x5a), false);
+    SHADERTOY_CHECK(decode(prefix + "QQ==") && decode(prefix + "QQ==")->size() == 97);
+    SHADERTOY_CHECK(!decode(prefix + "QQ="));
+    SHADERTOY_CHECK(!decode(prefix + "Q==="));
+}
+
+SHADERTOY_NAMESPACE_END
+
+int main() {
+    try {
+        ShaderToy::testRoundTrip();
+        ShaderToy::testInvalidCharacters();
+        ShaderToy::testPadding();
+    } catch(const ShaderToy::Error&) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#pragma once
+#include "shadertoy/Support.hpp"
+#include <cstdio>
+
+// Reports the failed condition and throws Error, which the main() of a test turns into a failure exit code
+#define SHADERTOY_CHECK(COND)                                                             \
+    do {                                                                                  \
+        if(!(COND)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #COND); \
+            throw ShaderToy::Error{};                                                     \
+        }                                                                                 \
+    } while(false)
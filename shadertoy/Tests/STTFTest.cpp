@@ -0,0 +1,247 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+// Saves a graph with every kind of asset node to both formats, loads it back and compares it with the original. The chunks of
+// the binary format are checked for deduplication and compression.
+
+#include "shadertoy/BlockCompression.hpp"
+#include "shadertoy/STTF.hpp"
+#include "shadertoy/Tests/Check.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+template <typename T>
+static std::vector<T> makeNoise(const size_t count, const uint32_t seed) {
+    std::mt19937 gen{ seed };
+    std::vector<T> data(count);
+    for(auto& value : data)
+        value = static_cast<T>(gen());
+    return data;
+}
+
+template <typename T>
+static T& addNode(ShaderToyTransmissionFormat& sttf, std::unique_ptr<T> node, std::string name) {
+    node->name = std::move(name);
+    auto& ref = *node;
+    sttf.nodes.push_back(std::move(node));
+    return ref;
+}
+
+// Texture and TextureCopy hold the same pixels
+static void makeGraph(ShaderToyTransmissionFormat& sttf) {
+    sttf.metadata.emplace("Name", "Round trip");
+    sttf.metadata.emplace("Author", "shadertoy");
+
+    auto& output = addNode(sttf, std::make_unique<RenderOutput>(), "RenderOutput");
+    constexpr auto imageSource = "void mainImage(out vec4 c, in vec2 p) {}";
+    constexpr auto cubeMapSource = "void mainCubemap(out vec4 c, in vec2 p, in vec3 o, in vec3 d) {}";
+    auto& image = addNode(sttf, std::make_unique<GLSLShader>(imageSource, NodeType::Image), "Image");
+    image.format = Format::RGBA16F;
+    auto& buffer = addNode(sttf, std::make_unique<GLSLShader>(imageSource, NodeType::Image), "Buffer A");
+    auto& cubeMapShader = addNode(sttf, std::make_unique<GLSLShader>(cubeMapSource, NodeType::CubeMap), "Cube A");
+    cubeMapShader.faceSize = 256;
+    auto& lastFrame = addNode(sttf, std::make_unique<LastFrame>("Buffer A", NodeType::Image), "LastFrame");
+    lastFrame.refNode = &buffer;
+    auto& keyboard = addNode(sttf, std::make_unique<Keyboard>(), "Keyboard");
+
+    const auto noise = makeNoise<uint32_t>(16 * 8, 1);
+    auto& texture = addNode(sttf, std::make_unique<Texture>(16, 8, noise), "Texture");
+    auto& textureCopy = addNode(sttf, std::make_unique<Texture>(16, 8, noise), "TextureCopy");
+    auto& flat = addNode(sttf, std::make_unique<Texture>(32, 32, std::vector<uint32_t>(32 * 32, 0xff336699)), "Flat");
+    auto& compressed = addNode(sttf, std::make_unique<Texture>(8, 8, std::vector<uint32_t>{}), "Compressed");
+    compressed.compressed = compressImage(8, 8, 1, makeNoise<uint32_t>(8 * 8, 2).data());
+    auto& cubeMap = addNode(sttf, std::make_unique<CubeMap>(4, makeNoise<uint32_t>(4 * 4 * 6, 3)), "CubeMap");
+    auto& volume = addNode(sttf, std::make_unique<Volume>(4, 1, makeNoise<uint8_t>(4 * 4 * 4, 4)), "Volume");
+
+    sttf.links = {
+        Link{ &image, &output, Filter::Linear, Wrap::Clamp, 0 },
+        Link{ &texture, &image, Filter::Mipmap, Wrap::Repeat, 0 },
+        Link{ &compressed, &image, Filter::Linear, Wrap::Repeat, 1 },
+        Link{ &cubeMap, &image, Filter::Linear, Wrap::Clamp, 2 },
+        Link{ &volume, &image, Filter::Nearest, Wrap::Repeat, 3 },
+        Link{ &textureCopy, &buffer, Filter::Nearest, Wrap::Clamp, 0 },
+        Link{ &lastFrame, &buffer, Filter::Linear, Wrap::Clamp, 1 },
+        Link{ &keyboard, &buffer, Filter::Nearest, Wrap::Clamp, 2 },
+        Link{ &flat, &cubeMapShader, Filter::Linear, Wrap::Repeat, 0 },
+    };
+}
+
+static bool isSameImage(const std::optional<CompressedImage>& lhs, const std::optional<CompressedImage>& rhs) {
+    if(!lhs || !rhs)
+        return !lhs && !rhs;
+    return lhs->format == rhs->format && lhs->width == rhs->width && lhs->height == rhs->height && lhs->faces == rhs->faces &&
+        lhs->data == rhs->data;
+}
+
+static void checkSameNode(const Node& lhs, const Node& rhs) {
+    SHADERTOY_CHECK(lhs.name == rhs.name);
+    SHADERTOY_CHECK(lhs.getNodeClass() == rhs.getNodeClass() && lhs.getNodeType() == rhs.getNodeType());
+    switch(lhs.getNodeClass()) {  // NOLINT(clang-diagnostic-switch-enum)
+        case NodeClass::GLSLShader: {
+            const auto& [a, b] = std::tie(dynamic_cast<const GLSLShader&>(lhs), dynamic_cast<const GLSLShader&>(rhs));
+            SHADERTOY_CHECK(a.source == b.source && a.format == b.format);
+            SHADERTOY_CHECK(a.nodeType != NodeType::CubeMap || a.faceSize == b.faceSize);
+            break;
+        }
+        case NodeClass::Texture: {
+            const auto& [a, b] = std::tie(dynamic_cast<const Texture&>(lhs), dynamic_cast<const Texture&>(rhs));
+            SHADERTOY_CHECK(a.width == b.width && a.height == b.height && a.pixel == b.pixel);
+            SHADERTOY_CHECK(isSameImage(a.compressed, b.compressed));
+            break;
+        }
+        case NodeClass::CubeMap: {
+            const auto& [a, b] = std::tie(dynamic_cast<const CubeMap&>(lhs), dynamic_cast<const CubeMap&>(rhs));
+            SHADERTOY_CHECK(a.size == b.size && a.pixel == b.pixel && isSameImage(a.compressed, b.compressed));
+            break;
+        }
+        case NodeClass::Volume: {
+            const auto& [a, b] = std::tie(dynamic_cast<const Volume&>(lhs), dynamic_cast<const Volume&>(rhs));
+            SHADERTOY_CHECK(a.size == b.size && a.channels == b.channels && a.pixel == b.pixel);
+            break;
+        }
+        case NodeClass::LastFrame: {
+            const auto& [a, b] = std::tie(dynamic_cast<const LastFrame&>(lhs), dynamic_cast<const LastFrame&>(rhs));
+            SHADERTOY_CHECK(a.refNodeName == b.refNodeName && b.refNode && b.refNode->name == a.refNodeName);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static void checkSameGraph(const ShaderToyTransmissionFormat& lhs, const ShaderToyTransmissionFormat& rhs) {
+    SHADERTOY_CHECK(lhs.metadata == rhs.metadata);
+    SHADERTOY_CHECK(lhs.nodes.size() == rhs.nodes.size());
+    for(size_t idx = 0; idx < lhs.nodes.size(); ++idx)
+        checkSameNode(*lhs.nodes[idx], *rhs.nodes[idx]);
+    SHADERTOY_CHECK(lhs.links.size() == rhs.links.size());
+    for(size_t idx = 0; idx < lhs.links.size(); ++idx) {
+        const auto& a = lhs.links[idx];
+        const auto& b = rhs.links[idx];
+        SHADERTOY_CHECK(a.start->name == b.start->name && a.end->name == b.end->name);
+        SHADERTOY_CHECK(a.filter == b.filter && a.wrapMode == b.wrapMode && a.slot == b.slot);
+    }
+}
+
+static void testRoundTrip(const std::filesystem::path& directory) {
+    ShaderToyTransmissionFormat original;
+    makeGraph(original);
+    constexpr std::pair<const char*, const char*> conversions[] = { { "graph.sttf", "converted.sttfb" },
+                                                                    { "graph.sttfb", "converted.sttf" } };
+    for(const auto& [name, convertedName] : conversions) {
+        const auto path = (directory / name).string();
+        original.save(path);
+        ShaderToyTransmissionFormat loaded;
+        loaded.load(path);
+        checkSameGraph(original, loaded);
+
+        // and to the other format, from the loaded graph
+        const auto convertedPath = (directory / convertedName).string();
+        loaded.save(convertedPath);
+        ShaderToyTransmissionFormat converted;
+        converted.load(convertedPath);
+        checkSameGraph(original, converted);
+    }
+}
+
+// The graph of the binary format is a JSON document after a 16-byte header with its size at offset 8
+static nlohmann::json readBinaryGraph(const std::string& path) {
+    std::ifstream file{ path, std::ios::binary };
+    const std::string data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+    SHADERTOY_CHECK(data.size() >= 16);
+    uint64_t size;
+    std::memcpy(&size, data.data() + 8, sizeof(size));
+    SHADERTOY_CHECK(size <= data.size() - 16);
+    return nlohmann::json::parse(data.cbegin() + 16, data.cbegin() + 16 + static_cast<ptrdiff_t>(size));
+}
+
+static void testChunks(const std::filesystem::path& directory) {
+    ShaderToyTransmissionFormat original;
+    makeGraph(original);
+    const auto path = (directory / "graph.sttfb").string();
+    original.save(path);
+    const auto json = readBinaryGraph(path);
+    const auto getChunk = [&](const std::string& name) -> const nlohmann::json& {
+        for(auto& node : json.at("nodes")) {
+            if(node.at("name") == name)
+                return json.at("chunks").at(node.at("chunk").get<size_t>());
+        }
+        throw Error{};
+    };
+
+    // Texture and TextureCopy share one chunk, Flat, Compressed, CubeMap and Volume have their own
+    SHADERTOY_CHECK(json.at("chunks").size() == 5);
+    SHADERTOY_CHECK(&getChunk("Texture") == &getChunk("TextureCopy"));
+    for(auto& chunk : json.at("chunks"))
+        SHADERTOY_CHECK(chunk.at("offset").get<size_t>() % 64 == 0);
+    // noise does not compress, a single color does
+    SHADERTOY_CHECK(getChunk("Texture").at("compression") == "None");
+    SHADERTOY_CHECK(getChunk("Texture").at("size") == 16 * 8 * sizeof(uint32_t));
+    SHADERTOY_CHECK(getChunk("Flat").at("compression") == "Zstd");
+    SHADERTOY_CHECK(getChunk("Flat").at("size").get<size_t>() < getChunk("Flat").at("rawSize").get<size_t>());
+}
+
+static void testDamagedFile(const std::filesystem::path& directory) {
+    ShaderToyTransmissionFormat original;
+    makeGraph(original);
+    const auto path = (directory / "graph.sttfb").string();
+    original.save(path);
+    // drop the last chunk
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 64);
+    ShaderToyTransmissionFormat loaded;
+    bool failed = false;
+    try {
+        loaded.load(path);
+    } catch(const Error&) {
+        failed = true;
+    }
+    SHADERTOY_CHECK(failed);
+}
+
+SHADERTOY_NAMESPACE_END
+
+int main() {
+    auto directory = (std::filesystem::temp_directory_path() / "shadertoy-test-XXXXXX").string();
+    if(!mkdtemp(directory.data()))
+        return EXIT_FAILURE;
+    const auto guard = ShaderToy::scopeExit([&] {
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    });
+    try {
+        ShaderToy::testRoundTrip(directory);
+        ShaderToy::testChunks(directory);
+        ShaderToy::testDamagedFile(directory);
+    } catch(const ShaderToy::Error&) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// Imports recorded shaders from a local stand-in for shadertoy.com, which serves the API responses in Fixtures/shadertoy and
+// the files in Fixtures/media. Usage: shadertoy-test-importer <success|missing-asset|offline|cancel> <fixture directory>
+
+#ifndef CPPHTTPLIB_OPENSSL_SUPPORT
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#endif
+
+#include "shadertoy/ShaderToyImporter.hpp"
+#include "shadertoy/Support.hpp"
+#include "shadertoy/Tests/Check.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <thread>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <hello_imgui/hello_imgui.h>
+#include <httplib.h>
+#include <stb_image.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+class StandInServer final {
+    httplib::Server mServer;
+    std::thread mThread;
+    std::atomic<uint32_t> mRequests{ 0 };
+    std::atomic<bool> mSlowStarted{ false };
+    std::atomic<bool> mClosing{ false };
+
+public:
+    explicit StandInServer(const std::filesystem::path& fixtures) {
+        mServer.set_pre_routing_handler([this](const httplib::Request&, httplib::Response&) {
+            ++mRequests;
+            return httplib::Server::HandlerResponse::Unhandled;
+        });
+        mServer.set_mount_point("/media", (fixtures / "media").string());
+        // the request body is s={"shaders":["<id>"]}&nt=1&nl=1&np=1
+        mServer.Post("/shadertoy", [fixtures](const httplib::Request& req, httplib::Response& res) {
+            const auto begin = req.body.find("[\"");
+            const auto end = req.body.find("\"]");
+            std::string id;
+            if(begin != std::string::npos && end != std::string::npos && begin < end)
+                id = req.body.substr(begin + 2, end - begin - 2);
+            std::ifstream file{ fixtures / "shadertoy" / (id + ".json") };
+            const auto isIdChar = [](const char ch) { return std::isalnum(static_cast<unsigned char>(ch)) != 0; };
+            if(id.empty() || !std::all_of(id.cbegin(), id.cend(), isIdChar) || !file) {
+                res.status = 404;
+                return;
+            }
+            res.set_content(std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} },
+                            "application/json");
+        });
+        // trickles bytes until the client hangs up, so that the transfer is running when it is cancelled
+        mServer.Get("/media/a/slow.png", [this](const httplib::Request&, httplib::Response& res) {
+            mSlowStarted = true;
+            res.set_content_provider(1 << 20, "image/png", [this](size_t, size_t, httplib::DataSink& sink) {
+                if(mClosing || !sink.is_writable())
+                    return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                return sink.write("\x89", 1);
+            });
+        });
+        const auto port = mServer.bind_to_any_port("127.0.0.1");
+        SHADERTOY_CHECK(port > 0);
+        mThread = std::thread{ [this] { mServer.listen_after_bind(); } };
+        const auto host = "http://127.0.0.1:" + std::to_string(port);
+        setenv("SHADERTOY_HOST", host.c_str(), 1);  // NOLINT(concurrency-mt-unsafe)
+    }
+    StandInServer(const StandInServer&) = delete;
+    StandInServer(StandInServer&&) = delete;
+    StandInServer& operator=(const StandInServer&) = delete;
+    StandInServer& operator=(StandInServer&&) = delete;
+    ~StandInServer() {
+        mClosing = true;
+        mServer.stop();
+        mThread.join();
+    }
+
+    [[nodiscard]] uint32_t getRequestCount() const noexcept {
+        return mRequests;
+    }
+    [[nodiscard]] bool isSlowStarted() const noexcept {
+        return mSlowStarted;
+    }
+};
+
+static std::unique_ptr<ShaderToyTransmissionFormat> finish(ShaderToyImporter& importer) {
+    while(!importer.poll())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return importer.takeResult();
+}
+
+static std::unique_ptr<ShaderToyTransmissionFormat> import(const std::string& shaderId, const bool offline) {
+    ShaderToyImporter importer{ shaderId, offline };
+    return finish(importer);
+}
+
+template <typename T>
+static const T* findNode(const ShaderToyTransmissionFormat& sttf) {
+    for(auto& node : sttf.nodes) {
+        if(const auto ptr = dynamic_cast<const T*>(node.get()))
+            return ptr;
+    }
+    return nullptr;
+}
+
+static void checkCheckerShader(const ShaderToyTransmissionFormat& sttf) {
+    SHADERTOY_CHECK(sttf.metadata.at("Name") == "Checker");
+    SHADERTOY_CHECK(sttf.metadata.at("ShaderToyURL") == "https://www.shadertoy.com/view/tstOk1");
+    const auto texture = findNode<Texture>(sttf);
+    SHADERTOY_CHECK(texture && texture->width == 4 && texture->height == 4 && texture->pixel.size() == 16);
+    // a 4x4 checker board of opaque white and black with a white top left corner, flipped vertically by the sampler
+    for(uint32_t y = 0; y < 4; ++y) {
+        for(uint32_t x = 0; x < 4; ++x)
+            SHADERTOY_CHECK(texture->pixel[y * 4 + x] == ((x + 3 - y) % 2 == 0 ? 0xffffffff : 0xff000000));
+    }
+    SHADERTOY_CHECK(findNode<Keyboard>(sttf) && findNode<RenderOutput>(sttf));
+    const auto shader = findNode<GLSLShader>(sttf);
+    SHADERTOY_CHECK(shader && shader->source.find("iChannel0") != std::string::npos);
+    SHADERTOY_CHECK(sttf.links.size() == 3);
+}
+
+static void testSuccess(StandInServer&) {
+    const auto sttf = import("https://www.shadertoy.com/view/tstOk1", false);
+    SHADERTOY_CHECK(sttf);
+    checkCheckerShader(*sttf);
+}
+
+static void testMissingAsset(StandInServer&) {
+    ShaderToyImporter importer{ "tst404", false };
+    SHADERTOY_CHECK(!finish(importer));
+    const auto assets = importer.getAssets();
+    SHADERTOY_CHECK(assets.size() == 1 && assets.front().path == "/media/a/missing.png" && !assets.front().done);
+}
+
+static void testOffline(StandInServer& server) {
+    SHADERTOY_CHECK(import("tstOk1", false));
+    SHADERTOY_CHECK(!import("tst404", false));
+    const auto requests = server.getRequestCount();
+
+    // hit: both the API response and the decoded texture come from the cache
+    const auto sttf = import("tstOk1", true);
+    SHADERTOY_CHECK(sttf);
+    checkCheckerShader(*sttf);
+    // miss: the shader was never imported
+    SHADERTOY_CHECK(!import("tstNone", true));
+    // miss: the API response is cached, but its texture was never downloaded
+    SHADERTOY_CHECK(!import("tst404", true));
+    SHADERTOY_CHECK(server.getRequestCount() == requests);
+}
+
+static void testCancel(StandInServer& server) {
+    ShaderToyImporter importer{ "tstSlow", false };
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while(!server.isSlowStarted() && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    SHADERTOY_CHECK(server.isSlowStarted());
+    importer.cancel();
+    SHADERTOY_CHECK(importer.isCancelled());
+    SHADERTOY_CHECK(!finish(importer));
+}
+
+static int runTest(const std::string_view name, const std::filesystem::path& fixtures) {
+    using Test = void (*)(StandInServer&);
+    constexpr std::pair<std::string_view, Test> tests[] = {
+        { "success", testSuccess },
+        { "missing-asset", testMissingAsset },
+        { "offline", testOffline },
+        { "cancel", testCancel },
+    };
+    const auto iter = std::find_if(std::begin(tests), std::end(tests), [&](const auto& test) { return test.first == name; });
+    if(iter == std::end(tests)) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Unknown test %.*s", static_cast<int>(name.size()), name.data());
+        return EXIT_FAILURE;
+    }
+
+    // each run starts with an empty media cache
+    auto cacheHome = (std::filesystem::temp_directory_path() / "shadertoy-test-XXXXXX").string();
+    SHADERTOY_CHECK(mkdtemp(cacheHome.data()));
+    const auto guard = scopeExit([&] {
+        std::error_code ec;
+        std::filesystem::remove_all(cacheHome, ec);
+    });
+    setenv("XDG_CACHE_HOME", cacheHome.c_str(), 1);  // NOLINT(concurrency-mt-unsafe)
+
+    StandInServer server{ fixtures };
+    iter->second(server);
+    return EXIT_SUCCESS;
+}
+
+SHADERTOY_NAMESPACE_END
+
+int main(const int argc, char** argv) {
+    if(argc != 3) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Usage: %s <test> <fixture directory>", argv[0]);
+        return EXIT_FAILURE;
+    }
+    try {
+        return ShaderToy::runTest(argv[1], argv[2]);
+    } catch(const ShaderToy::Error&) {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,280 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/PipelineBuilder.hpp"
+#include "shadertoy/Support.hpp"
+#include "shadertoy/Tools/Headless.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <GL/glew.h>
+#include <nlohmann/json.hpp>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+struct BenchmarkOptions final {
+    std::vector<std::string> inputs;
+    std::vector<std::pair<uint32_t, uint32_t>> resolutions;
+    uint32_t warmupFrames = 30;
+    uint32_t measuredFrames = 120;
+    std::string output;
+    std::string baseline;
+    double threshold = 0.1;
+};
+
+static void printUsage() {
+    std::fputs("Usage: shadertoy-benchmark [<file.sttf|directory>...] [--resolution <w>x<h>]... [--warmup <n>] [--frames <n>]\n"
+               "                          [--output <results.json>] [--baseline <results.json>] [--threshold <ratio>]\n"
+               "Benchmarks every sttf file in ./examples by default. Per-pass GPU statistics cover the last 128 frames.\n"
+               "Exits with 1 if the mean frame time of any case exceeds the baseline by more than the threshold (default 0.1).\n",
+               stderr);
+}
+
+static bool parseOptions(const int argc, char** argv, BenchmarkOptions& options) {
+    for(int idx = 1; idx < argc; ++idx) {
+        const std::string_view arg = argv[idx];
+        const auto next = [&]() -> const char* { return idx + 1 < argc ? argv[++idx] : nullptr; };
+        const char* value = nullptr;
+        if(arg == "-h" || arg == "--help")
+            return false;
+        if(arg == "--resolution") {
+            if(!(value = next()))
+                return false;
+            const std::string_view resolution = value;
+            const auto pos = resolution.find('x');
+            if(pos == std::string_view::npos)
+                return false;
+            const auto width = static_cast<uint32_t>(std::stoul(std::string{ resolution.substr(0, pos) }));
+            const auto height = static_cast<uint32_t>(std::stoul(std::string{ resolution.substr(pos + 1) }));
+            if(!width || !height)
+                return false;
+            options.resolutions.emplace_back(width, height);
+        } else if(arg == "--warmup") {
+            if(!(value = next()))
+                return false;
+            options.warmupFrames = static_cast<uint32_t>(std::stoul(value));
+        } else if(arg == "--frames") {
+            if(!(value = next()))
+                return false;
+            options.measuredFrames = static_cast<uint32_t>(std::stoul(value));
+        } else if(arg == "--output") {
+            if(!(value = next()))
+                return false;
+            options.output = value;
+        } else if(arg == "--baseline") {
+            if(!(value = next()))
+                return false;
+            options.baseline = value;
+        } else if(arg == "--threshold") {
+            if(!(value = next()))
+                return false;
+            options.threshold = std::stod(value);
+        } else if(!arg.empty() && arg.front() != '-') {
+            options.inputs.emplace_back(arg);
+        } else {
+            return false;
+        }
+    }
+    if(options.inputs.empty())
+        options.inputs.emplace_back("examples");
+    if(options.resolutions.empty())
+        options.resolutions.emplace_back(1280, 720);
+    return options.measuredFrames > 0;
+}
+
+static std::vector<std::string> collectInputs(const std::vector<std::string>& inputs) {
+    std::vector<std::string> files;
+    for(auto& input : inputs) {
+        if(std::filesystem::is_directory(input)) {
+            std::vector<std::string> entries;
+            for(auto& entry : std::filesystem::directory_iterator{ input }) {
+                if(entry.is_regular_file() && (entry.path().extension() == ".sttf" || entry.path().extension() == ".sttfb"))
+                    entries.push_back(entry.path().string());
+            }
+            std::sort(entries.begin(), entries.end());
+            files.insert(files.end(), entries.begin(), entries.end());
+        } else
+            files.push_back(input);
+    }
+    return files;
+}
+
+static nlohmann::json summarize(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for(const auto sample : samples)
+        sum += sample;
+    const auto percentile = [&](const double p) {
+        return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5)];
+    };
+    return { { "mean", sum / static_cast<double>(samples.size()) },
+             { "p50", percentile(0.50) },
+             { "p95", percentile(0.95) },
+             { "p99", percentile(0.99) } };
+}
+
+static double elapsedMs(const Clock::time_point start) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()) * 1e-6;
+}
+
+static nlohmann::json benchmark(const std::string& path, const uint32_t width, const uint32_t height,
+                                const BenchmarkOptions& options) {
+    nlohmann::json result;
+    result["file"] = std::filesystem::path{ path }.filename().string();
+    result["width"] = width;
+    result["height"] = height;
+
+    ShaderToyTransmissionFormat sttf;
+    sttf.load(path);
+    std::vector<std::unique_ptr<TextureObject>> textures;
+    const auto desc = describePipeline(sttf, textures);
+
+    const auto compileStart = Clock::now();
+    const auto pipeline = buildPipeline(desc);
+    pipeline->link();
+    glFinish();
+    result["compileMs"] = elapsedMs(compileStart);
+
+    const auto target = createRenderTarget(width, height);
+    const ImVec2 size{ static_cast<float>(width), static_cast<float>(height) };
+    target->bind();
+    std::vector<double> frameTime;
+    frameTime.reserve(options.measuredFrames);
+    for(uint32_t frame = 0; frame < options.warmupFrames + options.measuredFrames; ++frame) {
+        if(frame == options.warmupFrames)
+            pipeline->resetStatistics();
+        const auto start = Clock::now();
+        pipeline->render(size, ImVec2{ 0.0f, 0.0f }, size, size, offlineUniform(static_cast<int32_t>(frame), 60.0f, 0.0f));
+        glFinish();
+        if(frame >= options.warmupFrames)
+            frameTime.push_back(elapsedMs(start));
+    }
+    target->unbind();
+
+    result["frameMs"] = summarize(std::move(frameTime));
+    auto& passes = result["passes"];
+    passes = nlohmann::json::array();
+    for(auto& [name, mean, p50, p95, p99] : pipeline->getStatistics())
+        passes.push_back({ { "name", name }, { "mean", mean }, { "p50", p50 }, { "p95", p95 }, { "p99", p99 } });
+    result["renderTargetBytes"] = pipeline->getFrameBufferMemory();
+    return result;
+}
+
+static bool compareWithBaseline(const nlohmann::json& results, const nlohmann::json& baseline, const double threshold) {
+    bool regressed = false;
+    for(auto& result : results) {
+        for(auto& ref : baseline) {
+            if(ref.at("file") != result.at("file") || ref.at("width") != result.at("width") ||
+               ref.at("height") != result.at("height"))
+                continue;
+            const auto current = result.at("frameMs").at("mean").get<double>();
+            const auto expected = ref.at("frameMs").at("mean").get<double>();
+            if(current > expected * (1.0 + threshold)) {
+                HelloImGui::Log(HelloImGui::LogLevel::Error, "Regression in %s (%ux%u): %.3f ms -> %.3f ms",
+                                result.at("file").get<std::string>().c_str(), result.at("width").get<uint32_t>(),
+                                result.at("height").get<uint32_t>(), expected, current);
+                regressed = true;
+            }
+        }
+    }
+    return regressed;
+}
+
+static int benchmarkMain(const int argc, char** argv) {
+    BenchmarkOptions options;
+    try {
+        if(!parseOptions(argc, argv, options)) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    } catch(const std::exception&) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // compileMs measures the compiler, not program binaries cached by previous runs, and the user cache stays untouched
+    setenv("SHADERTOY_NO_PROGRAM_CACHE", "1", 1);  // NOLINT(concurrency-mt-unsafe)
+
+    nlohmann::json results = nlohmann::json::array();
+    bool failed = false;
+    try {
+        HeadlessContext context;
+        for(auto& path : collectInputs(options.inputs)) {
+            for(auto [width, height] : options.resolutions) {
+                HelloImGui::Log(HelloImGui::LogLevel::Info, "Benchmarking %s (%ux%u)", path.c_str(), width, height);
+                try {
+                    results.push_back(benchmark(path, width, height, options));
+                } catch(const Error&) {
+                    HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to benchmark %s", path.c_str());
+                    failed = true;
+                }
+            }
+        }
+    } catch(const Error&) {
+        return EXIT_FAILURE;
+    }
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const nlohmann::json report = { { "version", SHADERTOY_VERSION },
+                                    { "warmupFrames", options.warmupFrames },
+                                    { "measuredFrames", options.measuredFrames },
+                                    { "peakRssKB", usage.ru_maxrss },
+                                    { "results", results } };
+    if(options.output.empty())
+        std::cout << report.dump(4) << '\n';
+    else {
+        std::ofstream file{ options.output };
+        if(!file) {
+            HelloImGui::Log(HelloImGui::LogLevel::Error, "Cannot open file %s", options.output.c_str());
+            return EXIT_FAILURE;
+        }
+        file << report.dump(4) << '\n';
+    }
+
+    if(!options.baseline.empty()) {
+        std::ifstream file{ options.baseline };
+        if(!file) {
+            HelloImGui::Log(HelloImGui::LogLevel::Error, "Cannot open file %s", options.baseline.c_str());
+            return EXIT_FAILURE;
+        }
+        try {
+            nlohmann::json baseline;
+            file >> baseline;
+            if(compareWithBaseline(results, baseline.at("results"), options.threshold))
+                return EXIT_FAILURE;
+        } catch(const std::exception& ex) {
+            HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to parse baseline: %s", ex.what());
+            return EXIT_FAILURE;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+SHADERTOY_NAMESPACE_END
+
+int main(const int argc, char** argv) {
+    return ShaderToy::benchmarkMain(argc, argv);
+}
@@ -0,0 +1,128 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/Tools/Headless.hpp"
+#include "shadertoy/Support.hpp"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+#include <hello_imgui/hello_imgui.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+// The offline tools do not link the hello_imgui runner, so logs go straight to stderr.
+namespace HelloImGui {
+    void Log(const LogLevel level, const char* const format, ...) {
+        static constexpr const char* prefix[] = { "debug", "info", "warning", "error" };
+        std::fprintf(stderr, "[%s] ", prefix[static_cast<int>(level)]);
+        va_list args;
+        va_start(args, format);
+        std::vfprintf(stderr, format, args);
+        va_end(args);
+        std::fputc('\n', stderr);
+    }
+}  // namespace HelloImGui
+
+SHADERTOY_NAMESPACE_BEGIN
+
+[[noreturn]] void reportFatalError(std::string_view error) {
+    std::fprintf(stderr, "%.*s\n", static_cast<int>(error.size()), error.data());
+    std::abort();
+}
+
+[[noreturn]] void reportNotImplemented() {
+    reportFatalError("Not implemented feature");
+}
+
+static EGLDisplay getSurfacelessDisplay() {
+    const auto extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if(extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        const auto getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if(getPlatformDisplay) {
+            if(const auto display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+               display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+HeadlessContext::HeadlessContext() {
+    const auto display = getSurfacelessDisplay();
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to initialize EGL display (0x%x)", eglGetError());
+        throw Error{};
+    }
+    mDisplay = display;
+    auto displayGuard = scopeFail([&] { eglTerminate(display); });
+
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Desktop OpenGL is not supported by the EGL implementation");
+        throw Error{};
+    }
+
+    constexpr EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if(!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "No EGL config supports desktop OpenGL");
+        throw Error{};
+    }
+
+    constexpr EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION,
+                                          4,
+                                          EGL_CONTEXT_MINOR_VERSION,
+                                          1,
+                                          EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                          EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                          EGL_NONE };
+    const auto context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if(context == EGL_NO_CONTEXT) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to create OpenGL 4.1 core context (0x%x)", eglGetError());
+        throw Error{};
+    }
+    mContext = context;
+    auto contextGuard = scopeFail([&] { eglDestroyContext(display, context); });
+
+    // requires EGL_KHR_surfaceless_context
+    if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to make the surfaceless context current (0x%x)", eglGetError());
+        throw Error{};
+    }
+
+    glewExperimental = GL_TRUE;
+    // GLEW probes GLX after loading the core entry points, which fails without an X display. That is expected here.
+    if(const auto ret = glewInit(); ret != GLEW_OK && ret != GLEW_ERROR_NO_GLX_DISPLAY) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to initialize glew: %s",
+                        reinterpret_cast<const char*>(glewGetErrorString(ret)));
+        throw Error{};
+    }
+    HelloImGui::Log(HelloImGui::LogLevel::Info, "OpenGL renderer: %s", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+}
+
+HeadlessContext::~HeadlessContext() {
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(mDisplay, mContext);
+    eglTerminate(mDisplay);
+}
+
+SHADERTOY_NAMESPACE_END
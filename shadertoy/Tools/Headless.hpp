@@ -0,0 +1,35 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Backend.hpp"
+#include "shadertoy/Config.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+// Surfaceless EGL context with desktop OpenGL 4.1 core, so pipelines can run without a display (e.g. on llvmpipe).
+class HeadlessContext final {
+    void* mDisplay = nullptr;
+    void* mContext = nullptr;
+
+public:
+    HeadlessContext();
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext(HeadlessContext&&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(HeadlessContext&&) = delete;
+    ~HeadlessContext();
+};
+
+SHADERTOY_NAMESPACE_END
@@ -0,0 +1,183 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/PipelineBuilder.hpp"
+#include "shadertoy/Support.hpp"
+#include "shadertoy/Tools/Headless.hpp"
+#include "shadertoy/VideoWriter.hpp"
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <GL/glew.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+struct RenderOptions final {
+    std::string input;
+    std::string output = "frame";
+    std::string video;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t frames = 1;
+    float fps = 60.0f;
+    float startTime = 0.0f;
+};
+
+static void printUsage() {
+    std::fputs("Usage: shadertoy-render <input.sttf> [-o <prefix>] [--width <w>] [--height <h>] [--frames <n>] [--fps <fps>] "
+               "[--start <secs>] [--video <path|\"|cmd\">]\n"
+               "Writes <prefix>00000.png, <prefix>00001.png, ...\n"
+               "With --video, frames are streamed as Y4M into a file or the stdin of cmd (raw RGBA for *.rgba), e.g.\n"
+               "  --video \"|ffmpeg -y -i - out.mp4\"\n",
+               stderr);
+}
+
+static bool parseOptions(const int argc, char** argv, RenderOptions& options) {
+    for(int idx = 1; idx < argc; ++idx) {
+        const std::string_view arg = argv[idx];
+        const auto next = [&]() -> const char* { return idx + 1 < argc ? argv[++idx] : nullptr; };
+        const char* value = nullptr;
+        if(arg == "-h" || arg == "--help")
+            return false;
+        if(arg == "-o" || arg == "--output") {
+            if(!(value = next()))
+                return false;
+            options.output = value;
+        } else if(arg == "--width") {
+            if(!(value = next()))
+                return false;
+            options.width = static_cast<uint32_t>(std::stoul(value));
+        } else if(arg == "--height") {
+            if(!(value = next()))
+                return false;
+            options.height = static_cast<uint32_t>(std::stoul(value));
+        } else if(arg == "--frames") {
+            if(!(value = next()))
+                return false;
+            options.frames = static_cast<uint32_t>(std::stoul(value));
+        } else if(arg == "--fps") {
+            if(!(value = next()))
+                return false;
+            options.fps = std::stof(value);
+        } else if(arg == "--start") {
+            if(!(value = next()))
+                return false;
+            options.startTime = std::stof(value);
+        } else if(arg == "--video") {
+            if(!(value = next()))
+                return false;
+            options.video = value;
+        } else if(options.input.empty() && !arg.empty() && arg.front() != '-') {
+            options.input = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.input.empty() && options.width && options.height && options.fps > 0.0f;
+}
+
+// Reading back frame N is deferred until frame N + depth has been submitted, so the GPU never waits for the encoder.
+static bool renderVideo(const RenderOptions& options, Pipeline& pipeline, RenderTarget& target) {
+    constexpr uint32_t readbackDepth = 4;
+    VideoWriter writer{ options.video, options.width, options.height, options.fps };
+    const auto ring = createReadbackRing(options.width, options.height, readbackDepth);
+    const ImVec2 size{ static_cast<float>(options.width), static_cast<float>(options.height) };
+    const auto popFrame = [&] {
+        auto frame = writer.acquireFrame();
+        ring->pop(frame.data(), true);
+        writer.submitFrame(std::move(frame));
+    };
+    for(uint32_t frame = 0; frame < options.frames; ++frame) {
+        target.bind();
+        pipeline.render(size, ImVec2{ 0.0f, 0.0f }, size, size,
+                        offlineUniform(static_cast<int32_t>(frame), options.fps, options.startTime));
+        target.unbind();
+        if(ring->full())
+            popFrame();
+        ring->push(target);
+    }
+    while(!ring->empty())
+        popFrame();
+    if(!writer.finish())
+        return false;
+    HelloImGui::Log(HelloImGui::LogLevel::Info, "Rendered %u frames to %s", options.frames, options.video.c_str());
+    return true;
+}
+
+static int renderMain(const int argc, char** argv) {
+    RenderOptions options;
+    try {
+        if(!parseOptions(argc, argv, options)) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    } catch(const std::exception&) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        HeadlessContext context;
+
+        ShaderToyTransmissionFormat sttf;
+        sttf.load(options.input);
+        std::vector<std::unique_ptr<TextureObject>> textures;
+        const auto pipeline = buildPipeline(describePipeline(sttf, textures));
+        pipeline->link();
+        const auto target = createRenderTarget(options.width, options.height);
+
+        const ImVec2 size{ static_cast<float>(options.width), static_cast<float>(options.height) };
+        if(!options.video.empty())
+            return renderVideo(options, *pipeline, *target) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+        std::vector<uint32_t> pixels(static_cast<size_t>(options.width) * options.height);
+        std::string path;
+        stbi_flip_vertically_on_write(1);
+        for(uint32_t frame = 0; frame < options.frames; ++frame) {
+            target->bind();
+            pipeline->render(size, ImVec2{ 0.0f, 0.0f }, size, size,
+                             offlineUniform(static_cast<int32_t>(frame), options.fps, options.startTime));
+            target->readPixels(pixels.data());
+            target->unbind();
+            for(auto& pixel : pixels)
+                pixel |= 0xff000000;  // ShaderToy ignores the alpha channel of the final output
+
+            char suffix[16];
+            std::snprintf(suffix, sizeof(suffix), "%05u.png", frame);
+            path = options.output + suffix;
+            if(!stbi_write_png(path.c_str(), static_cast<int>(options.width), static_cast<int>(options.height), 4, pixels.data(),
+                               static_cast<int>(options.width * 4))) {
+                HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to write %s", path.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+        HelloImGui::Log(HelloImGui::LogLevel::Info, "Rendered %u frames", options.frames);
+    } catch(const Error&) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+SHADERTOY_NAMESPACE_END
+
+int main(const int argc, char** argv) {
+    return ShaderToy::renderMain(argc, argv);
+}
@@ -0,0 +1,189 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "shadertoy/VideoWriter.hpp"
+#include "shadertoy/Support.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+#include "shadertoy/SuppressWarningPush.hpp"
+
+#include <hello_imgui/hello_imgui.h>
+
+#include "shadertoy/SuppressWarningPop.hpp"
+
+SHADERTOY_NAMESPACE_BEGIN
+
+#if defined(SHADERTOY_WINDOWS)
+static FILE* openPipe(const char* command) {
+    return _popen(command, "wb");
+}
+static int closePipe(FILE* pipe) {
+    return _pclose(pipe);
+}
+#else
+static FILE* openPipe(const char* command) {
+    return popen(command, "w");
+}
+static int closePipe(FILE* pipe) {
+    return pclose(pipe);
+}
+#endif
+
+VideoWriter::VideoWriter(const std::string& output, const uint32_t width, const uint32_t height, const float frameRate)
+    : mWidth{ width }, mHeight{ height }, mFrameRate{ frameRate } {
+    const std::string_view view = output;
+    if(!view.empty() && view.front() == '|') {
+        mPipe = true;
+        mFile = openPipe(output.c_str() + 1);
+    } else {
+        mY4M = view.size() < 5 || view.substr(view.size() - 5) != ".rgba";
+        mFile = std::fopen(output.c_str(), "wb");
+    }
+    if(!mFile) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Cannot open %s", output.c_str());
+        throw Error{};
+    }
+    if(mY4M) {
+        // the frame rate is stored as a fraction
+        const auto rate = static_cast<uint32_t>(std::lround(static_cast<double>(frameRate) * 1000.0));
+        std::fprintf(mFile, "YUV4MPEG2 W%u H%u F%u:1000 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height, rate);
+    }
+    mThread = std::thread{ [this] { run(); } };
+}
+
+VideoWriter::~VideoWriter() {
+    finish();
+}
+
+std::vector<uint32_t> VideoWriter::acquireFrame() {
+    {
+        std::lock_guard lock{ mMutex };
+        if(!mFreeFrames.empty()) {
+            auto frame = std::move(mFreeFrames.back());
+            mFreeFrames.pop_back();
+            return frame;
+        }
+    }
+    return std::vector<uint32_t>(static_cast<size_t>(mWidth) * mHeight);
+}
+
+void VideoWriter::submitFrame(std::vector<uint32_t> frame) {
+    std::unique_lock lock{ mMutex };
+    mCondition.wait(lock, [&] { return mQueue.size() < maxQueuedFrames; });
+    mQueue.push_back(std::move(frame));
+    mCondition.notify_all();
+}
+
+bool VideoWriter::finish() {
+    if(mThread.joinable()) {
+        {
+            std::lock_guard lock{ mMutex };
+            mClosing = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+    if(mFile) {
+        const auto ret = mPipe ? closePipe(mFile) : std::fclose(mFile);
+        mFile = nullptr;
+        if(ret != 0) {
+            HelloImGui::Log(HelloImGui::LogLevel::Error, mPipe ? "Encoder exited with status %d" : "Failed to close video (%d)",
+                            ret);
+            mFailed = true;
+        }
+    }
+    return !mFailed;
+}
+
+void VideoWriter::run() {
+    std::vector<uint8_t> buffer;
+    while(true) {
+        std::vector<uint32_t> frame;
+        {
+            std::unique_lock lock{ mMutex };
+            mCondition.wait(lock, [&] { return mClosing || !mQueue.empty(); });
+            if(mQueue.empty())
+                return;
+            frame = std::move(mQueue.front());
+            mQueue.pop_front();
+            mCondition.notify_all();
+        }
+        // frames after a failure are dropped, finish() reports it
+        const auto success = mFailed || write(frame, buffer);
+        std::lock_guard lock{ mMutex };
+        mFailed = mFailed || !success;
+        mFreeFrames.push_back(std::move(frame));
+    }
+}
+
+bool VideoWriter::write(const std::vector<uint32_t>& frame, std::vector<uint8_t>& buffer) const {
+    const auto width = static_cast<size_t>(mWidth);
+    const auto height = static_cast<size_t>(mHeight);
+    // the frames are bottom row first
+    const auto row = [&](const size_t y) { return frame.data() + (height - 1 - y) * width; };
+    const auto channel = [](const uint32_t pixel, const uint32_t shift) { return static_cast<int32_t>((pixel >> shift) & 0xff); };
+
+    if(!mY4M) {
+        buffer.resize(width * height * 4);
+        for(size_t y = 0; y < height; ++y) {
+            const auto src = row(y);
+            for(size_t x = 0; x < width; ++x) {
+                const auto pixel = src[x] | 0xff000000;  // ShaderToy ignores the alpha channel of the final output
+                std::memcpy(buffer.data() + (y * width + x) * 4, &pixel, sizeof(pixel));
+            }
+        }
+        return std::fwrite(buffer.data(), 1, buffer.size(), mFile) == buffer.size();
+    }
+
+    // 8-bit fixed point BT.601 (JPEG) coefficients, chroma is sampled from the average of each 2x2 block
+    const auto chromaWidth = (width + 1) / 2;
+    const auto chromaHeight = (height + 1) / 2;
+    buffer.resize(width * height + chromaWidth * chromaHeight * 2);
+    const auto lumaPlane = buffer.data();
+    const auto cbPlane = lumaPlane + width * height;
+    const auto crPlane = cbPlane + chromaWidth * chromaHeight;
+    for(size_t y = 0; y < height; ++y) {
+        const auto src = row(y);
+        const auto dst = lumaPlane + y * width;
+        for(size_t x = 0; x < width; ++x) {
+            const auto pixel = src[x];
+            const auto luma = 77 * channel(pixel, 0) + 150 * channel(pixel, 8) + 29 * channel(pixel, 16);
+            dst[x] = static_cast<uint8_t>((luma + 128) >> 8);
+        }
+    }
+    for(size_t cy = 0; cy < chromaHeight; ++cy) {
+        const auto row0 = row(cy * 2);
+        const auto row1 = row(std::min(cy * 2 + 1, height - 1));
+        for(size_t cx = 0; cx < chromaWidth; ++cx) {
+            const auto x0 = cx * 2;
+            const auto x1 = std::min(x0 + 1, width - 1);
+            const auto average = [&](const uint32_t shift) {
+                return (channel(row0[x0], shift) + channel(row0[x1], shift) + channel(row1[x0], shift) +
+                        channel(row1[x1], shift) + 2) /
+                    4;
+            };
+            const auto r = average(0), g = average(8), b = average(16);
+            cbPlane[cy * chromaWidth + cx] = static_cast<uint8_t>(std::min((-43 * r - 85 * g + 128 * b + 32896) >> 8, 255));
+            crPlane[cy * chromaWidth + cx] = static_cast<uint8_t>(std::min((128 * r - 107 * g - 21 * b + 32896) >> 8, 255));
+        }
+    }
+    static constexpr char frameHeader[] = "FRAME\n";
+    return std::fwrite(frameHeader, 1, sizeof(frameHeader) - 1, mFile) == sizeof(frameHeader) - 1 &&
+        std::fwrite(buffer.data(), 1, buffer.size(), mFile) == buffer.size();
+}
+
+SHADERTOY_NAMESPACE_END
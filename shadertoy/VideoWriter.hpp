@@ -0,0 +1,78 @@
+/*
+    SPDX-License-Identifier: Apache-2.0
+    Copyright 2023-2025 Yingwei Zheng
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+        http://www.apache.org/licenses/LICENSE-2.0
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#pragma once
+#include "shadertoy/Config.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+SHADERTOY_NAMESPACE_BEGIN
+
+// Streams frames on a writer thread, either to a file or into the stdin of an external encoder.
+// "|<command>" pipes Y4M into command (e.g. "|ffmpeg -y -i - out.mp4"). A path ending with .rgba gets raw R8G8B8A8 frames with
+// the top row first, and any other path gets Y4M (4:2:0, full range BT.601).
+class VideoWriter final {
+    static constexpr size_t maxQueuedFrames = 8;
+
+    uint32_t mWidth, mHeight;
+    float mFrameRate;
+    FILE* mFile = nullptr;
+    bool mPipe = false;
+    bool mY4M = true;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::vector<uint32_t>> mQueue;
+    std::vector<std::vector<uint32_t>> mFreeFrames;
+    bool mClosing = false;
+    bool mFailed = false;
+    std::thread mThread;
+
+    void run();
+    [[nodiscard]] bool write(const std::vector<uint32_t>& frame, std::vector<uint8_t>& buffer) const;
+
+public:
+    // throws Error if the output cannot be opened
+    VideoWriter(const std::string& output, uint32_t width, uint32_t height, float frameRate);
+    VideoWriter(const VideoWriter&) = delete;
+    VideoWriter(VideoWriter&&) = delete;
+    VideoWriter& operator=(const VideoWriter&) = delete;
+    VideoWriter& operator=(VideoWriter&&) = delete;
+    ~VideoWriter();
+
+    // width * height pixels, recycled from written frames
+    [[nodiscard]] std::vector<uint32_t> acquireFrame();
+    // R8G8B8A8 with the bottom row first, blocks while the writer is maxQueuedFrames behind
+    void submitFrame(std::vector<uint32_t> frame);
+    // writes the queued frames and closes the output, returns false if anything failed
+    bool finish();
+
+    [[nodiscard]] uint32_t width() const noexcept {
+        return mWidth;
+    }
+    [[nodiscard]] uint32_t height() const noexcept {
+        return mHeight;
+    }
+    [[nodiscard]] float frameRate() const noexcept {
+        return mFrameRate;
+    }
+};
+
+SHADERTOY_NAMESPACE_END
@@ -15,14 +15,15 @@
 #include "shadertoy/Config.hpp"
 #include "shadertoy/NodeEditor/PipelineEditor.hpp"
 #include "shadertoy/ShaderToyContext.hpp"
+#include <cmath>
 #include <cstdlib>
+#include <future>
 
 #include "shadertoy/SuppressWarningPush.hpp"
 
 #include <fmt/format.h>
 #include <hello_imgui/dpi_aware.h>
 #include <hello_imgui/hello_imgui.h>
-#include <hello_imgui/hello_imgui_screenshot.h>
 #include <httplib.h>
 #include <magic_enum.hpp>
 #include <misc/cpp/imgui_stdlib.h>
@@ -66,60 +67,110 @@ static void openURL(const std::string& url) {
 #endif
 }
 
-static std::optional<std::function<void()>> takeScreenshot;
 static bool endsWith(const std::string_view& str, const std::string_view& pattern) {
     return str.size() >= pattern.size() && str.substr(str.size() - pattern.size()) == pattern;
 }
 static bool startsWith(const std::string_view& str, const std::string_view& pattern) {
     return str.size() >= pattern.size() && str.substr(0, pattern.size()) == pattern;
 }
-static void saveScreenshot(const ImVec4& bound) {
-    const auto [width, height, bufferRgb] = HelloImGui::AppWindowScreenshotRgbBuffer();
-    if(bufferRgb.empty()) {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to get screenshot since it is not supported by the backend");
-        return;
+// runs on a worker thread
+static bool writeScreenshot(const std::string& path, const uint32_t width, const uint32_t height,
+                            const std::vector<uint32_t>& pixels) {
+    // R8G8B8A8 bottom row first -> R8G8B8 top row first
+    std::vector<uint8_t> img(static_cast<size_t>(width) * height * 3);
+    for(uint32_t y = 0; y < height; ++y) {
+        const auto src = reinterpret_cast<const uint8_t*>(pixels.data() + static_cast<size_t>(height - 1 - y) * width);
+        const auto dst = img.data() + static_cast<size_t>(y) * width * 3;
+        for(uint32_t x = 0; x < width; ++x)
+            std::copy(src + static_cast<size_t>(x) * 4, src + static_cast<size_t>(x) * 4 + 3, dst + static_cast<size_t>(x) * 3);
     }
 
-    std::vector<uint8_t> img;
-    const auto bx = std::max(static_cast<int32_t>(bound.x), 0), by = std::max(static_cast<int32_t>(bound.y), 0),
-               ex = std::min(static_cast<int32_t>(bound.z), static_cast<int32_t>(width)),
-               ey = std::min(static_cast<int32_t>(bound.w), static_cast<int32_t>(height));
-    if(bx >= ex || by >= ey)
-        return;
+    const auto w = static_cast<int>(width);
+    const auto h = static_cast<int>(height);
+    const auto data = img.data();
+    if(endsWith(path, ".png"))
+        return stbi_write_png(path.c_str(), w, h, 3, data, w * 3) != 0;
+    if(endsWith(path, ".jpg"))
+        return stbi_write_jpg(path.c_str(), w, h, 3, data, 90) != 0;
+    if(endsWith(path, ".bmp"))
+        return stbi_write_bmp(path.c_str(), w, h, 3, data) != 0;
+    return stbi_write_tga(path.c_str(), w, h, 3, data) != 0;
+}
 
-    const auto w = ex - bx;
-    const auto h = ey - by;
-    img.resize(static_cast<size_t>(w * h) * 3);
-    for(auto y = by; y < ey; ++y) {
-        std::copy(bufferRgb.begin() + static_cast<ptrdiff_t>((static_cast<size_t>(y) * width + bx) * 3),
-                  bufferRgb.begin() + static_cast<ptrdiff_t>((static_cast<size_t>(y) * width + bx + w) * 3),
-                  img.begin() + static_cast<ptrdiff_t>(static_cast<size_t>(y - by) * w * 3));
+static std::vector<std::pair<std::string, std::future<bool>>> screenshotWriters;
+static void pollScreenshotWriters() {
+    for(auto iter = screenshotWriters.begin(); iter != screenshotWriters.end();) {
+        auto& [path, writer] = *iter;
+        if(writer.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready) {
+            ++iter;
+            continue;
+        }
+        if(writer.get())
+            HelloImGui::Log(HelloImGui::LogLevel::Info, "Saved screenshot to %s", path.c_str());
+        else
+            HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to save the screenshot");
+        iter = screenshotWriters.erase(iter);
     }
+}
 
-    nfdchar_t* path;
-    if(NFD_SaveDialog("png,jpg,bmp,tga", nullptr, &path) != NFD_OKAY)
+// width and height are 0 for the canvas size
+static void saveScreenshot(ShaderToyContext& ctx, const uint32_t width, const uint32_t height) {
+    nfdchar_t* selectedPath;
+    if(NFD_SaveDialog("png,jpg,bmp,tga", nullptr, &selectedPath) != NFD_OKAY)
+        return;
+    const std::string path = selectedPath;
+    if(!endsWith(path, ".png") && !endsWith(path, ".jpg") && !endsWith(path, ".bmp") && !endsWith(path, ".tga")) {
+        HelloImGui::Log(HelloImGui::LogLevel::Error, "Unrecognized image format");
         return;
+    }
 
-    auto handleStbError = [](const int ret) {
-        if(ret == 0) {
-            HelloImGui::Log(HelloImGui::LogLevel::Error, "Failed to save the screenshot");
-        }
-    };
+    // encoding takes a while for large captures, keep it off the UI thread
+    ctx.captureScreenshot(width, height, [path](const uint32_t w, const uint32_t h, std::vector<uint32_t> pixels) {
+        auto writer =
+            std::async(std::launch::async, [=, pixels = std::move(pixels)] { return writeScreenshot(path, w, h, pixels); });
+        screenshotWriters.emplace_back(path, std::move(writer));
+    });
+}
 
-    const std::string_view imgPath = path;
-    const auto data = img.data();
-    const auto stride = w * 3;
-    if(endsWith(imgPath, ".png")) {
-        handleStbError(stbi_write_png(path, w, h, 3, data, stride));
-    } else if(endsWith(imgPath, ".jpg")) {
-        handleStbError(stbi_write_jpg(path, w, h, 3, data, 90));
-    } else if(endsWith(imgPath, ".bmp")) {
-        handleStbError(stbi_write_bmp(path, w, h, 3, data));
-    } else if(endsWith(imgPath, ".tga")) {
-        handleStbError(stbi_write_tga(path, w, h, 3, data));
-    } else {
-        HelloImGui::Log(HelloImGui::LogLevel::Error, "Unrecognized image format");
+static void showExportPopup(ShaderToyContext& ctx, const ImVec2 canvasSize) {
+    static int videoSize[2] = { 0, 0 };
+    static float videoFrameRate = 60.0f;
+    static float videoDuration = 10.0f;
+    static std::string videoOutput = "|ffmpeg -y -i - -c:v libx264 -pix_fmt yuv420p output.mp4";
+    if(!ImGui::BeginPopup("ExportVideo"))
+        return;
+
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::InputInt2("size (0: canvas)", videoSize);
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::InputFloat("fps", &videoFrameRate);
+    ImGui::SetNextItemWidth(150.0f);
+    ImGui::InputFloat("duration (s)", &videoDuration);
+    ImGui::SetNextItemWidth(400.0f);
+    ImGui::InputText("output", &videoOutput);
+    ImGui::SameLine();
+    if(ImGui::Button("...")) {
+        nfdchar_t* path;
+        if(NFD_SaveDialog("y4m,rgba", nullptr, &path) == NFD_OKAY)
+            videoOutput = path;
     }
+    ImGui::TextUnformatted("*.y4m: YUV4MPEG2, *.rgba: raw frames, \"|<command>\": pipes YUV4MPEG2 into an encoder");
+
+    const auto frames = static_cast<uint32_t>(std::lround(std::max(videoDuration * videoFrameRate, 0.0f)));
+    ImGui::BeginDisabled(!ctx.isValid() || videoFrameRate <= 0.0f || frames == 0 || videoOutput.empty());
+    if(ImGui::Button("Export")) {
+        const auto useCanvas = videoSize[0] <= 0 || videoSize[1] <= 0;
+        const auto width = static_cast<uint32_t>(std::max(useCanvas ? static_cast<int>(canvasSize.x) : videoSize[0], 1));
+        const auto height = static_cast<uint32_t>(std::max(useCanvas ? static_cast<int>(canvasSize.y) : videoSize[1], 1));
+        try {
+            ctx.startExport(std::make_unique<VideoWriter>(videoOutput, width, height, videoFrameRate), frames);
+        } catch(const Error&) {
+            // already logged
+        }
+        ImGui::CloseCurrentPopup();
+    }
+    ImGui::EndDisabled();
+    ImGui::EndPopup();
 }
 
 static void showCanvas(ShaderToyContext& ctx) {
@@ -168,18 +219,65 @@ static void showCanvas(ShaderToyContext& ctx) {
     ImGui::Text("% 6.2f % 9.2f fps % 4d x% 4d [%d %d %d %d]", static_cast<double>(ctx.getTime()),
                 static_cast<double>(ImGui::GetIO().Framerate), static_cast<int>(size.x), static_cast<int>(size.y),
                 static_cast<int>(mouse.x), static_cast<int>(mouse.y), static_cast<int>(mouse.z), static_cast<int>(mouse.w));
+    if(const auto statistics = ctx.getStatistics(); !statistics.empty()) {
+        float gpuTime = 0.0f;
+        const PassStatistics* heaviest = nullptr;
+        for(auto& stats : statistics) {
+            gpuTime += stats.mean;
+            if(!heaviest || stats.mean > heaviest->mean)
+                heaviest = &stats;
+        }
+        ImGui::SameLine();
+        ImGui::Text("GPU %.2f ms (%s)", static_cast<double>(gpuTime), heaviest->name.c_str());
+        if(ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::Text("%-16s %8s %8s %8s %8s", "pass", "mean", "p50", "p95", "p99");
+            for(auto& stats : statistics)
+                ImGui::Text("%-16s %8.3f %8.3f %8.3f %8.3f", stats.name.c_str(), static_cast<double>(stats.mean),
+                            static_cast<double>(stats.p50), static_cast<double>(stats.p95), static_cast<double>(stats.p99));
+            ImGui::EndTooltip();
+        }
+    }
     ImGui::SameLine();
+    static int screenshotSize[2] = { 0, 0 };
     if(ImGui::Button(ICON_FA_CAMERA)) {
-        takeScreenshot = [&ctx] { saveScreenshot(ctx.getBound()); };
+        saveScreenshot(ctx, static_cast<uint32_t>(std::max(screenshotSize[0], 0)),
+                       static_cast<uint32_t>(std::max(screenshotSize[1], 0)));
+    }
+    if(ImGui::BeginPopupContextItem("ScreenshotSize")) {
+        ImGui::SetNextItemWidth(150.0f);
+        ImGui::InputInt2("screenshot size (0: canvas)", screenshotSize);
+        ImGui::EndPopup();
+    }
+    ImGui::SameLine();
+    if(ctx.isExporting()) {
+        if(ImGui::Button(ICON_FA_STOP))
+            ctx.stopExport();
+        ImGui::SameLine();
+        ImGui::ProgressBar(ctx.getExportProgress(), ImVec2{ 100.0f, 0.0f });
+    } else {
+        if(ImGui::Button(ICON_FA_FILM))
+            ImGui::OpenPopup("ExportVideo");
+        showExportPopup(ctx, size);
     }
     ImGui::SameLine();
     ImGui::SetNextItemWidth(100.0f);
     ImGui::DragFloat("timescale (log2)", &ctx.getTimeScale(), 0.01f, -16.0f, 16.0f, "%.1f");
+    ImGui::SameLine();
+    ImGui::Checkbox("dynamic resolution", &ctx.getDynamicResolution());
+    if(ctx.getDynamicResolution()) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(60.0f);
+        ImGui::DragFloat("target fps", &ctx.getTargetFrameRate(), 1.0f, 15.0f, 240.0f, "%.0f");
+        ImGui::SameLine();
+        ImGui::Text("%3d%%", static_cast<int>(ctx.getResolutionScale() * 100.0f + 0.5f));
+    }
     ImGui::End();
 }
 
 static std::string url;
-static bool openImportModal = false, openAboutModal = false;
+static bool openImportModal = false, openAboutModal = false, offlineImport = false;
+static bool importing = false;  // the import modal shows the progress until the import finished
 
 static void showMenu() {
     if(ImGui::BeginMenu("File")) {
@@ -189,14 +287,14 @@ static void showMenu() {
         }
         if(ImGui::MenuItem("Open shader")) {
             nfdchar_t* path;
-            if(NFD_OpenDialog("sttf", nullptr, &path) == NFD_OKAY) {
+            if(NFD_OpenDialog("sttf,sttfb", nullptr, &path) == NFD_OKAY) {
                 editor.loadSTTF(path);
             }
         }
         if(ImGui::MenuItem("Save shader")) {
             // const auto defaultPath = editor.getShaderName() + ".sttf";
             nfdchar_t* path;
-            if(NFD_SaveDialog("sttf", nullptr, &path) == NFD_OKAY) {
+            if(NFD_SaveDialog("sttf;sttfb", nullptr, &path) == NFD_OKAY) {
                 editor.saveSTTF(path);
             }
         }
@@ -231,23 +329,37 @@ static void showImportModal() {
     ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
 
     if(ImGui::BeginPopupModal("Import Shader", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-        ImGui::TextUnformatted(ICON_FA_LINK "URL");
-        ImGui::SameLine();
-        ImGui::SetNextItemWidth(ImGui::CalcTextSize("https://www.shadertoy.com/view/WWWWWWXXXX").x);
-        ImGui::InputText("##Url", &url, ImGuiInputTextFlags_CharsNoBlank);
-
-        if(ImGui::Button("Import", EmToVec2(5, 0))) {
-            try {
-                PipelineEditor::get().loadFromShaderToy(url);
-            } catch(const std::exception&) {
-                Log(HelloImGui::LogLevel::Error, "Failed to import %s", url.c_str());
+        const auto width = ImGui::CalcTextSize("https://www.shadertoy.com/view/WWWWWWXXXX").x;
+        auto& editor = PipelineEditor::get();
+        if(const auto importer = editor.getPendingImport(); importer && importing) {
+            ImGui::TextUnformatted(importer->getUrl().c_str());
+            for(auto& [path, done] : importer->getAssets())
+                ImGui::Text("%s %s", done ? ICON_FA_CHECK : ICON_FA_HOURGLASS, path.c_str());
+            ImGui::ProgressBar(importer->getProgress(), ImVec2{ width, 0.0f });
+            if(importer->isCancelled()) {
+                ImGui::TextUnformatted("Cancelling...");
+            } else if(ImGui::Button("Cancel", EmToVec2(5, 0))) {
+                editor.cancelImport();
             }
+        } else if(importing) {
+            importing = false;
             ImGui::CloseCurrentPopup();
-        }
-        ImGui::SetItemDefaultFocus();
-        ImGui::SameLine();
-        if(ImGui::Button("Cancel", EmToVec2(5, 0))) {
-            ImGui::CloseCurrentPopup();
+        } else {
+            ImGui::TextUnformatted(ICON_FA_LINK "URL");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(width);
+            ImGui::InputText("##Url", &url, ImGuiInputTextFlags_CharsNoBlank);
+            ImGui::Checkbox("Offline (cached shaders only)", &offlineImport);
+
+            if(ImGui::Button("Import", EmToVec2(5, 0))) {
+                editor.loadFromShaderToy(url, offlineImport);
+                importing = true;
+            }
+            ImGui::SetItemDefaultFocus();
+            ImGui::SameLine();
+            if(ImGui::Button("Cancel", EmToVec2(5, 0))) {
+                ImGui::CloseCurrentPopup();
+            }
         }
         ImGui::EndPopup();
     }
@@ -323,12 +435,7 @@ int shaderToyMain(int argc, char** argv) {
         showImportModal();
         showAboutModal();
     };
-    runnerParams.callbacks.PreNewFrame = [] {
-        if(takeScreenshot.has_value()) {
-            (*takeScreenshot)();
-            takeScreenshot.reset();
-        }
-    };
+    runnerParams.callbacks.PreNewFrame = [] { pollScreenshotWriters(); };
 
     runnerParams.callbacks.LoadAdditionalFonts = [] { HelloImGui::ImGuiDefaultSettings::LoadDefaultFont_WithFontAwesomeIcons(); };
 
@@ -356,7 +463,7 @@ int shaderToyMain(int argc, char** argv) {
         if(!initialPipeline.empty()) {
             if(startsWith(initialPipeline, "https://")) {
                 PipelineEditor::get().loadFromShaderToy(initialPipeline);
-            } else if(endsWith(initialPipeline, ".sttf")) {
+            } else if(endsWith(initialPipeline, ".sttf") || endsWith(initialPipeline, ".sttfb")) {
                 PipelineEditor::get().loadSTTF(initialPipeline);
             } else {
                 HelloImGui::Log(HelloImGui::LogLevel::Error, "Unrecognized filepath %s", initialPipeline.c_str());